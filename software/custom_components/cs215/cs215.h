@@ -13,6 +13,7 @@ class CS215Component : public PollingComponent, public sdi12::SDI12Device {
   public:
     void set_humidity_sensor(sensor::Sensor *humidity_sensor) { humidity_sensor_ = humidity_sensor; }
     void set_temperature_sensor(sensor::Sensor *temperature_sensor) { temperature_sensor_ = temperature_sensor; }
+    void set_concurrent(bool concurrent) { concurrent_ = concurrent; }
 
     float get_setup_priority() const override;
     void setup() override;
@@ -23,14 +24,10 @@ class CS215Component : public PollingComponent, public sdi12::SDI12Device {
     sensor::Sensor *humidity_sensor_;
     sensor::Sensor *direction_sensor_;
     sensor::Sensor *temperature_sensor_;
-    void loop() override;
+    bool concurrent_{false};
 
  private:
-/**
-   * send_data_() issues the command which requests the sensor to send its data.
-*/
-    void send_data_();
-    uint32_t send_data_timestamp_{0};
+    void handle_values_(const float *values, size_t count, const sdi12::SDI12ValidValues &valid);
 };
 
 }  // namespace cs215
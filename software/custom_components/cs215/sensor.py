@@ -15,6 +15,8 @@ from esphome.const import (
 
 DEPENDENCIES = ["sdi12"]
 
+CONF_CONCURRENT = "concurrent"
+
 _LOGGER = logging.getLogger(__name__)
 
 cs215_ns = cg.esphome_ns.namespace("cs215")
@@ -37,6 +39,7 @@ CONFIG_SCHEMA = (
                 unit_of_measurement=UNIT_CELSIUS,
                 accuracy_decimals=1,
             ),
+            cv.Optional(CONF_CONCURRENT, default=False): cv.boolean,
         }
     )
     .extend(cv.polling_component_schema("5s"))
@@ -47,6 +50,7 @@ async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     await sdi12.register_sdi12_device(var, config)
+    cg.add(var.set_concurrent(config[CONF_CONCURRENT]))
 
     if CONF_HUMIDITY in config:
         conf = config[CONF_HUMIDITY]
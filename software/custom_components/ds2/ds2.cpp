@@ -1,3 +1,4 @@
+#include <cmath>
 #include "ds2.h"
 
 namespace esphome {
@@ -11,49 +12,129 @@ float DS2Component::get_setup_priority() const {
 
 void DS2Component::setup() {
     ESP_LOGI(TAG, "setup() DS2 Anemometer @ SDI-12 Address '%c'", this->address_);
+
+    if (this->use_streaming_) {
+        this->start_streaming_(0, [this](sdi12::SDI12Status status, std::string_view response) {
+            if (status == sdi12::SDI12Status::OK)
+                this->handle_sample_(response);
+        }, this->sample_interval_);
+    }
 }
 
 void DS2Component::update() {
-    if (this->bus_->is_scanning())
+    if (this->use_streaming_) {
+        this->publish_aggregates_();
         return;
+    }
+
+    this->read_continuous_(0, [this](sdi12::SDI12Status status, std::string_view response) {
+        if (status != sdi12::SDI12Status::OK) {
+            ESP_LOGW(TAG, "Reading failed: %s", sdi12::sdi12_status_to_string(status));
+            return;
+        }
+        this->handle_response_(response);
+    }, this->phase_offset_);
+}
+
+bool DS2Component::parse_response_(std::string_view response, float &wind_speed, float &wind_direction,
+                                   float &wind_temperature) {
+    if (response.empty() || response[0] != this->address_) {
+        ESP_LOGW(TAG, "Response format is incorrect.");
+        return false;
+    }
 
-    std::string request(1, this->address_);
-    request += "R0!";
-    std::string response = this->bus_->send_command(request);
-    ESP_LOGI(TAG, "Received DS2 sensor response: '%s'", response.c_str());
+    // Speed, direction and temperature after the address, NAN where one isn't a number
+    float values[3];
+    sdi12::SDI12ParseResult result = sdi12::sdi12_parse_values(response.substr(1), values, 3);
+    if (result.count < 3) {
+        ESP_LOGW(TAG, "Response has %u of 3 values.", static_cast<unsigned>(result.count));
+        return false;
+    }
+    if (!result.all_valid(3))
+        ESP_LOGW(TAG, "Response has invalid values: '%.*s'", static_cast<int>(response.length()), response.data());
 
-    // Expected fixed string at the beginning of the response
-    std::string expected_prefix(1, this->address_);
-    expected_prefix += "+";
+    wind_speed = values[0];
+    wind_direction = values[1];
+    wind_temperature = values[2];
+    return true;
+}
 
-    if (response.rfind(expected_prefix, 0) == 0) {
-        // Strip the fixed prefix and prepare float variables
-        std::string values_str = response.substr(expected_prefix.length());
-        float wind_speed, wind_direction, wind_temperature;
+void DS2Component::handle_response_(std::string_view response) {
+    ESP_LOGI(TAG, "Received DS2 sensor response: '%.*s'", static_cast<int>(response.length()), response.data());
 
-        this->parse_sdi12_values_(values_str, {&wind_speed, &wind_direction, &wind_temperature});
+    float wind_speed, wind_direction, wind_temperature;
+    if (!this->parse_response_(response, wind_speed, wind_direction, wind_temperature))
+        return;
 
-        ESP_LOGI(TAG, "Parsed Wind Speed: %.3f km/h", wind_speed);
-        ESP_LOGI(TAG, "Parsed Wind Direction: %.0f degrees", wind_direction);
-        ESP_LOGI(TAG, "Parsed Wind Temperature: %.3f °C", wind_temperature);
+    ESP_LOGI(TAG, "Parsed Wind Speed: %.3f km/h", wind_speed);
+    ESP_LOGI(TAG, "Parsed Wind Direction: %.0f degrees", wind_direction);
+    ESP_LOGI(TAG, "Parsed Wind Temperature: %.3f °C", wind_temperature);
 
-        if (this->windspeed_sensor_ != nullptr) {
-            this->windspeed_sensor_->publish_state(wind_speed);
-        }
-        if (this->direction_sensor_ != nullptr) {
-            this->direction_sensor_->publish_state(wind_direction);
-        }
-        if (this->temperature_sensor_ != nullptr) {
-            this->temperature_sensor_->publish_state(wind_temperature);
-        }
-    } else {
-        ESP_LOGW(TAG, "Response format is incorrect.");
+    if (this->windspeed_sensor_ != nullptr) {
+        this->windspeed_sensor_->publish_state(wind_speed);
+    }
+    if (this->direction_sensor_ != nullptr) {
+        this->direction_sensor_->publish_state(wind_direction);
+    }
+    if (this->temperature_sensor_ != nullptr) {
+        this->temperature_sensor_->publish_state(wind_temperature);
+    }
+    if (this->gust_sensor_ != nullptr) {
+        this->gust_sensor_->publish_state(wind_speed);
+    }
+}
+
+void DS2Component::handle_sample_(std::string_view response) {
+    ESP_LOGV(TAG, "Received DS2 sample: '%.*s'", static_cast<int>(response.length()), response.data());
+
+    float wind_speed, wind_direction, wind_temperature;
+    if (!this->parse_response_(response, wind_speed, wind_direction, wind_temperature))
+        return;
+
+    // Directions are averaged as unit vectors, 350° and 10° have to give 0° and not 180°
+    float radians = wind_direction * static_cast<float>(M_PI) / 180.0f;
+    this->samples_.push(millis(), {wind_speed, std::sin(radians), std::cos(radians), wind_temperature});
+}
+
+void DS2Component::publish_aggregates_() {
+    uint32_t now = millis();
+    uint32_t window = this->get_update_interval();
+    sdi12::SDI12Aggregate speed = this->samples_.aggregate(0, window, now);
+    sdi12::SDI12Aggregate sine = this->samples_.aggregate(1, window, now);
+    sdi12::SDI12Aggregate cosine = this->samples_.aggregate(2, window, now);
+    sdi12::SDI12Aggregate temperature = this->samples_.aggregate(3, window, now);
+    if (speed.count == 0) {
+        ESP_LOGW(TAG, "No samples received in the last %u ms", window);
+        return;
+    }
+
+    float direction = std::atan2(sine.mean, cosine.mean) * 180.0f / static_cast<float>(M_PI);
+    if (direction < 0)
+        direction += 360.0f;
+
+    ESP_LOGD(TAG, "%u samples: wind speed %.3f km/h (%.3f - %.3f), direction %.0f degrees, temperature %.3f °C",
+             speed.count, speed.mean, speed.min, speed.max, direction, temperature.mean);
+
+    if (this->windspeed_sensor_ != nullptr) {
+        this->windspeed_sensor_->publish_state(speed.mean);
+    }
+    if (this->direction_sensor_ != nullptr) {
+        this->direction_sensor_->publish_state(direction);
+    }
+    if (this->temperature_sensor_ != nullptr) {
+        this->temperature_sensor_->publish_state(temperature.mean);
+    }
+    if (this->gust_sensor_ != nullptr) {
+        this->gust_sensor_->publish_state(speed.max);
     }
 }
 
 void DS2Component::dump_config() {
   ESP_LOGCONFIG(TAG, "DS2:");
   LOG_SDI12_DEVICE(this);
+  ESP_LOGCONFIG(TAG, "  Streaming: %s", YESNO(this->use_streaming_));
+  if (this->use_streaming_)
+    ESP_LOGCONFIG(TAG, "  Sample Interval: %u ms", this->sample_interval_);
 }
 
 }  // namespace ds2
@@ -9,11 +9,18 @@ namespace ds2 {
 
 using namespace esphome;
 
+/// Samples kept while streaming, enough for an update interval of several seconds at full rate
+static const size_t DS2_SAMPLES = 64;
+
 class DS2Component : public PollingComponent, public sdi12::SDI12Device {
   public:
     void set_windspeed_sensor(sensor::Sensor *windspeed_sensor) { windspeed_sensor_ = windspeed_sensor; }
     void set_direction_sensor(sensor::Sensor *direction_sensor) { direction_sensor_ = direction_sensor; }
     void set_temperature_sensor(sensor::Sensor *temperature_sensor) { temperature_sensor_ = temperature_sensor; }
+    void set_gust_sensor(sensor::Sensor *gust_sensor) { gust_sensor_ = gust_sensor; }
+    /// sample continuously and publish the aggregates of each update interval
+    void set_streaming(bool streaming) { use_streaming_ = streaming; }
+    void set_sample_interval(uint32_t sample_interval) { sample_interval_ = sample_interval; }
 
     float get_setup_priority() const override;
     void setup() override;
@@ -21,9 +28,21 @@ class DS2Component : public PollingComponent, public sdi12::SDI12Device {
     void update() override;
 
   protected:
-    sensor::Sensor *windspeed_sensor_;
-    sensor::Sensor *direction_sensor_;
-    sensor::Sensor *temperature_sensor_;
+    sensor::Sensor *windspeed_sensor_{nullptr};
+    sensor::Sensor *direction_sensor_{nullptr};
+    sensor::Sensor *temperature_sensor_{nullptr};
+    sensor::Sensor *gust_sensor_{nullptr};
+    bool use_streaming_{false};
+    uint32_t sample_interval_{0};
+    /// wind speed, the sine and cosine of the direction, and the temperature of each sample
+    sdi12::SDI12SampleRing<DS2_SAMPLES, 4> samples_;
+
+  private:
+    bool parse_response_(std::string_view response, float &wind_speed, float &wind_direction,
+                         float &wind_temperature);
+    void handle_response_(std::string_view response);
+    void handle_sample_(std::string_view response);
+    void publish_aggregates_();
 };
 
 }  // namespace ds2
@@ -21,6 +21,10 @@ _LOGGER = logging.getLogger(__name__)
 
 ds2_ns = cg.esphome_ns.namespace("ds2")
 
+CONF_WIND_GUST = "wind_gust"
+CONF_STREAMING = "streaming"
+CONF_SAMPLE_INTERVAL = "sample_interval"
+
 DS2Component = ds2_ns.class_(
     "DS2Component", cg.PollingComponent, sdi12.SDI12Device
 )
@@ -35,6 +39,12 @@ CONFIG_SCHEMA = (
                 device_class=DEVICE_CLASS_WIND_SPEED,
                 state_class=STATE_CLASS_MEASUREMENT,
             ),
+            cv.Optional(CONF_WIND_GUST): sensor.sensor_schema(
+                unit_of_measurement=UNIT_KILOMETER_PER_HOUR,
+                accuracy_decimals=2,
+                device_class=DEVICE_CLASS_WIND_SPEED,
+                state_class=STATE_CLASS_MEASUREMENT,
+            ),
             cv.Optional(CONF_WIND_DIRECTION_DEGREES): sensor.sensor_schema(
                 unit_of_measurement=UNIT_DEGREES,
                 accuracy_decimals=0,
@@ -47,6 +57,8 @@ CONFIG_SCHEMA = (
                 device_class=DEVICE_CLASS_WIND_SPEED,
                 state_class=STATE_CLASS_MEASUREMENT,
             ),
+            cv.Optional(CONF_STREAMING, default=False): cv.boolean,
+            cv.Optional(CONF_SAMPLE_INTERVAL, default="0ms"): cv.positive_time_period_milliseconds,
         }
     )
     .extend(cv.polling_component_schema("5s"))
@@ -63,6 +75,11 @@ async def to_code(config):
         sens = await sensor.new_sensor(conf)
         cg.add(var.set_windspeed_sensor(sens))
 
+    if CONF_WIND_GUST in config:
+        conf = config[CONF_WIND_GUST]
+        sens = await sensor.new_sensor(conf)
+        cg.add(var.set_gust_sensor(sens))
+
     if CONF_WIND_DIRECTION_DEGREES in config:
         conf = config[CONF_WIND_DIRECTION_DEGREES]
         sens = await sensor.new_sensor(conf)
@@ -72,3 +89,6 @@ async def to_code(config):
         conf = config[CONF_TEMPERATURE]
         sens = await sensor.new_sensor(conf)
         cg.add(var.set_temperature_sensor(sens))
+
+    cg.add(var.set_streaming(config[CONF_STREAMING]))
+    cg.add(var.set_sample_interval(config[CONF_SAMPLE_INTERVAL]))
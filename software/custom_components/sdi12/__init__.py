@@ -12,17 +12,48 @@ from esphome.const import (
     CONF_ENABLE_PIN,
     CONF_SCAN,
     CONF_ADDRESS,
+    CONF_VALUE,
+    CONF_STEP,
+    CONF_ACCURACY_DECIMALS,
+    CONF_MODEL,
+    CONF_VERSION,
 )
-from esphome.core import coroutine_with_priority, CORE
+from esphome.core import coroutine_with_priority, CORE, ID
 
 _LOGGER = logging.getLogger(__name__)
 
 CONF_SDI12_ID = "sdi12_id"
+CONF_FIRST_BYTE_TIMEOUT = "first_byte_timeout"
+CONF_INTER_CHARACTER_TIMEOUT = "inter_character_timeout"
+CONF_DEFERRED_DECODING = "deferred_decoding"
+CONF_RETRIES = "retries"
+CONF_WAKE_TIME = "wake_time"
+CONF_ADAPTIVE_TIMING = "adaptive_timing"
+CONF_PERFORMANCE_COUNTERS = "performance_counters"
+CONF_TOPOLOGY_CACHE = "topology_cache"
+CONF_PRIORITY = "priority"
+CONF_PHASE_OFFSET = "phase_offset"
+CONF_CRC = "crc"
+CONF_PHY_ID = "phy_id"
+CONF_EMULATED_SENSORS = "emulated_sensors"
+CONF_COUNT = "count"
+CONF_VENDOR = "vendor"
+CONF_MEASUREMENT_TIME = "measurement_time"
+CONF_LATENCY = "latency"
+CONF_DROP_RATE = "drop_rate"
+CONF_CORRUPT_RATE = "corrupt_rate"
+CONF_VALUES = "values"
+CONF_NOISE = "noise"
+
+# all addresses in the order the emulated sensors take them with count
+SDI12_ADDRESSES = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
 
 CODEOWNERS = ["@fraxinas"]
 sdi12_ns = cg.esphome_ns.namespace("sdi12")
 SDI12Bus = sdi12_ns.class_("SDI12Bus", cg.Component)
 SDI12Device = sdi12_ns.class_("SDI12Device")
+SDI12LoopbackPhy = sdi12_ns.class_("SDI12LoopbackPhy")
+SDI12EmulatedSensor = sdi12_ns.class_("SDI12EmulatedSensor")
 
 MULTI_CONF = True
 
@@ -35,16 +66,96 @@ def validate_rx_pin(value):
         raise cv.Invalid("Pins GPIO16 and GPIO17 cannot be used as RX pins on ESP8266.")
     return value
 
+def sdi12_address_validator(value):
+    value = cv.string(value)
+    if re.match(r"^[0-9a-zA-Z]{1}$", value) is not None:
+        return value
+    raise cv.Invalid(f"Invalid SDI12 Address: {value}. Has to be a single character of [0-1] or [a-z] or [A-Z]!")
+
+EMULATED_VALUE_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_VALUE): cv.float_,
+        cv.Optional(CONF_STEP, default=0.0): cv.float_,
+        cv.Optional(CONF_NOISE, default=0.0): cv.positive_float,
+        cv.Optional(CONF_ACCURACY_DECIMALS, default=2): cv.int_range(min=0, max=7),
+    }
+)
+
+def validate_emulated_sensor(config):
+    first = SDI12_ADDRESSES.index(config[CONF_ADDRESS])
+    if first + config[CONF_COUNT] > len(SDI12_ADDRESSES):
+        raise cv.Invalid(
+            f"{config[CONF_COUNT]} sensors from address {config[CONF_ADDRESS]} on "
+            f"need more than the {len(SDI12_ADDRESSES)} SDI-12 addresses"
+        )
+    return config
+
+EMULATED_SENSOR_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(SDI12EmulatedSensor),
+            cv.Required(CONF_ADDRESS): sdi12_address_validator,
+            cv.Optional(CONF_COUNT, default=1): cv.int_range(min=1, max=len(SDI12_ADDRESSES)),
+            cv.Optional(CONF_VENDOR, default="ESPHOME"): cv.All(cv.string, cv.Length(max=8)),
+            cv.Optional(CONF_MODEL, default="EMUL"): cv.All(cv.string, cv.Length(max=6)),
+            cv.Optional(CONF_VERSION, default="100"): cv.All(cv.string, cv.Length(max=3)),
+            cv.Optional(CONF_MEASUREMENT_TIME, default="1s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_LATENCY, default="9ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(milliseconds=9)),
+            ),
+            cv.Optional(CONF_WAKE_TIME, default="0ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(max=cv.TimePeriod(milliseconds=100)),
+            ),
+            cv.Optional(CONF_DROP_RATE, default="0%"): cv.percentage,
+            cv.Optional(CONF_CORRUPT_RATE, default="0%"): cv.percentage,
+            cv.Required(CONF_VALUES): cv.All(cv.ensure_list(EMULATED_VALUE_SCHEMA), cv.Length(min=1, max=99)),
+        }
+    ),
+    validate_emulated_sensor,
+)
+
+def validate_line(config):
+    """A bus either drives its pins or a loopback line to emulated sensors."""
+    if CONF_EMULATED_SENSORS in config:
+        addresses = []
+        for conf in config[CONF_EMULATED_SENSORS]:
+            first = SDI12_ADDRESSES.index(conf[CONF_ADDRESS])
+            addresses += SDI12_ADDRESSES[first:first + conf[CONF_COUNT]]
+        duplicates = sorted({address for address in addresses if addresses.count(address) > 1})
+        if duplicates:
+            raise cv.Invalid(f"Several emulated sensors at address {', '.join(duplicates)}")
+        return config
+    for pin in (CONF_RX_PIN, CONF_TX_PIN, CONF_ENABLE_PIN):
+        if pin not in config:
+            raise cv.Invalid(f"'{pin}' is required unless the bus runs emulated sensors")
+    return config
+
 CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
             cv.GenerateID(): _bus_declare_type,
+            cv.GenerateID(CONF_PHY_ID): cv.declare_id(SDI12LoopbackPhy),
             cv.Optional(CONF_TX_PIN): pins.internal_gpio_output_pin_schema,
             cv.Optional(CONF_RX_PIN): validate_rx_pin,
             cv.Optional(CONF_ENABLE_PIN): pins.internal_gpio_output_pin_schema,
             cv.Optional(CONF_SCAN, default=False): cv.boolean,
+            cv.Optional(CONF_TOPOLOGY_CACHE, default=True): cv.boolean,
+            cv.Optional(CONF_FIRST_BYTE_TIMEOUT, default="15ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_INTER_CHARACTER_TIMEOUT, default="10ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_DEFERRED_DECODING, default=False): cv.boolean,
+            cv.Optional(CONF_RETRIES, default=2): cv.int_range(min=0, max=5),
+            cv.Optional(CONF_WAKE_TIME, default="100ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(max=cv.TimePeriod(milliseconds=100)),
+            ),
+            cv.Optional(CONF_ADAPTIVE_TIMING, default=True): cv.boolean,
+            cv.Optional(CONF_PERFORMANCE_COUNTERS, default=False): cv.boolean,
+            cv.Optional(CONF_EMULATED_SENSORS): cv.All(cv.ensure_list(EMULATED_SENSOR_SCHEMA), cv.Length(min=1)),
         }
     ).extend(cv.COMPONENT_SCHEMA),
+    validate_line,
 )
 
 @coroutine_with_priority(1.0)
@@ -53,16 +164,60 @@ async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
 
-    tx_pin = await cg.gpio_pin_expression(config[CONF_TX_PIN])
-    cg.add(var.set_tx_pin(tx_pin))
+    if CONF_EMULATED_SENSORS in config:
+        # the loopback line and the emulator are only built for it, they need the heap
+        cg.add_define("USE_SDI12_EMULATOR")
+        phy = cg.new_Pvariable(config[CONF_PHY_ID])
+        cg.add(var.set_phy(phy))
+        for conf in config[CONF_EMULATED_SENSORS]:
+            await emulated_sensors_to_code(phy, conf)
+    else:
+        tx_pin = await cg.gpio_pin_expression(config[CONF_TX_PIN])
+        cg.add(var.set_tx_pin(tx_pin))
 
-    rx_pin = await cg.gpio_pin_expression(config[CONF_RX_PIN])
-    cg.add(var.set_rx_pin(rx_pin))
+        rx_pin = await cg.gpio_pin_expression(config[CONF_RX_PIN])
+        cg.add(var.set_rx_pin(rx_pin))
 
-    oe_pin = await cg.gpio_pin_expression(config[CONF_ENABLE_PIN])
-    cg.add(var.set_oe_pin(oe_pin))
+        oe_pin = await cg.gpio_pin_expression(config[CONF_ENABLE_PIN])
+        cg.add(var.set_oe_pin(oe_pin))
 
     cg.add(var.set_scan(config[CONF_SCAN]))
+    # also for a bus that only scans when start_scan() is called
+    if config[CONF_TOPOLOGY_CACHE]:
+        cg.add(var.set_topology_cache(str(config[CONF_ID])))
+    cg.add(var.set_first_byte_timeout(config[CONF_FIRST_BYTE_TIMEOUT]))
+    cg.add(var.set_inter_character_timeout(config[CONF_INTER_CHARACTER_TIMEOUT]))
+    cg.add(var.set_deferred_decoding(config[CONF_DEFERRED_DECODING]))
+    cg.add(var.set_retries(config[CONF_RETRIES]))
+    cg.add(var.set_wake_time(config[CONF_WAKE_TIME]))
+    cg.add(var.set_adaptive_timing(config[CONF_ADAPTIVE_TIMING]))
+    cg.add(var.set_performance_counters(config[CONF_PERFORMANCE_COUNTERS]))
+
+async def emulated_sensors_to_code(phy, config):
+    """Put the emulated sensors of one entry on the loopback line, count of them at consecutive addresses."""
+    first = SDI12_ADDRESSES.index(config[CONF_ADDRESS])
+    for n in range(config[CONF_COUNT]):
+        address = SDI12_ADDRESSES[first + n]
+        sensor_id = config[CONF_ID]
+        if n > 0:
+            sensor_id = ID(f"{sensor_id.id}_{n}", is_declaration=True, type=SDI12EmulatedSensor)
+        var = cg.new_Pvariable(sensor_id)
+        cg.add(var.set_address(cg.RawExpression(f"'{address}'")))
+        # vendor, model and version in their fixed widths, the address as serial number
+        identification = (
+            config[CONF_VENDOR].ljust(8) + config[CONF_MODEL].ljust(6) + config[CONF_VERSION].ljust(3) + address
+        )
+        cg.add(var.set_identification(identification))
+        cg.add(var.set_measurement_time(config[CONF_MEASUREMENT_TIME]))
+        cg.add(var.set_latency(config[CONF_LATENCY]))
+        cg.add(var.set_wake_time(config[CONF_WAKE_TIME]))
+        cg.add(var.set_drop_rate(config[CONF_DROP_RATE]))
+        cg.add(var.set_corrupt_rate(config[CONF_CORRUPT_RATE]))
+        for value in config[CONF_VALUES]:
+            cg.add(
+                var.add_value(value[CONF_VALUE], value[CONF_STEP], value[CONF_NOISE], value[CONF_ACCURACY_DECIMALS])
+            )
+        cg.add(var.set_phy(phy))
 
 def sdi12_device_schema(default_address):
     """Create a schema for an SDI-12 device.
@@ -73,6 +228,9 @@ def sdi12_device_schema(default_address):
     """
     schema = {
         cv.GenerateID(CONF_SDI12_ID): cv.use_id(SDI12Bus),
+        cv.Optional(CONF_PRIORITY, default=0): cv.int_range(min=-10, max=10),
+        cv.Optional(CONF_PHASE_OFFSET, default="0ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_CRC, default=False): cv.boolean,
     }
     if default_address is None:
         schema[cv.Required(CONF_ADDRESS)] = sdi12_address_validator
@@ -80,22 +238,20 @@ def sdi12_device_schema(default_address):
         schema[cv.Optional(CONF_ADDRESS, default=default_address)] = sdi12_address_validator
     return cv.Schema(schema)
 
-def sdi12_address_validator(value):
-    value = cv.string(value)
-    if re.match(r"^[0-9a-zA-Z]{1}$", value) is not None:
-        return value
-    raise cv.Invalid(f"Invalid SDI12 Address: {value}. Has to be a single character of [0-1] or [a-z] or [A-Z]!")
-
 async def register_sdi12_device(var, config):
     """Register an SDI-12 device with the given config.
 
-    Sets the SDI-12 bus to use and the SDI-12 address.
+    Sets the SDI-12 bus to use, the SDI-12 address, the scheduling parameters and whether
+    measurements are requested with a CRC.
 
     This is a coroutine, you need to await it with a 'yield' expression!
     """
     parent = await cg.get_variable(config[CONF_SDI12_ID])
     cg.add(var.set_sdi12_bus(parent))
     cg.add(var.set_sdi12_address(config[CONF_ADDRESS]))
+    cg.add(var.set_sdi12_priority(config[CONF_PRIORITY]))
+    cg.add(var.set_sdi12_phase_offset(config[CONF_PHASE_OFFSET]))
+    cg.add(var.set_sdi12_crc(config[CONF_CRC]))
 
 
 def final_validate_device_schema(
@@ -1,7 +1,9 @@
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstring>
 #include <vector>
-#include <sstream>
 #include <string>
-#include <iomanip>
 #include "sdi12.h"
 #include "esphome/core/log.h"
 
@@ -10,59 +12,332 @@ namespace sdi12 {
 
 static const char *const TAG = "sdi12";
 
+// Interval of the scheduler statistics in the log
+static const uint32_t STATISTICS_INTERVAL = 60000;
+// Delay of the next read of a stream after a failed one, in ms
+static const uint32_t STREAM_RETRY_INTERVAL = 1000;
+// The probes of a scan get at least one transaction in this many on a busy bus
+static const uint8_t SCAN_SHARE = 8;
+
+// The learned wake time of a device is lowered by this much with every answer, and kept
+// this far above a wake time the device missed
+static const uint32_t WAKE_STEP_MS = 10;
+static const uint32_t WAKE_MARGIN_MS = 20;
+// Answers needed before the first byte timeout follows the response latency, and the
+// margin it keeps above the slowest recent one
+static const uint8_t LATENCY_SAMPLES = 4;
+static const uint32_t LATENCY_MARGIN_US = 3000;
+
+SDI12Bus *SDI12Bus::transmitting_ = nullptr;
+
+// A response is complete once its <CR><LF> terminator arrived
+static bool has_terminator(std::string_view response) {
+  size_t len = response.length();
+  return len >= 2 && response[len - 2] == '\r' && response[len - 1] == '\n';
+}
+
+// The number at the start of @p digits, like strtoul() but without a terminating NUL
+static uint32_t parse_number(std::string_view digits) {
+  uint32_t value = 0;
+  for (char c : digits) {
+    if (c < '0' || c > '9')
+      break;
+    value = value * 10 + (c - '0');
+  }
+  return value;
+}
+
+const char *sdi12_status_to_string(SDI12Status status) {
+  switch (status) {
+    case SDI12Status::OK:
+      return "OK";
+    case SDI12Status::TIMEOUT:
+      return "timeout";
+    case SDI12Status::NOT_INITIALIZED:
+      return "bus not initialized";
+    case SDI12Status::BUSY:
+      return "busy";
+    case SDI12Status::INVALID_RESPONSE:
+      return "invalid response";
+    case SDI12Status::LINE_ERROR:
+      return "line error";
+    case SDI12Status::CRC_ERROR:
+      return "CRC error";
+    case SDI12Status::INVALID_COMMAND:
+      return "invalid command";
+    default:
+      return "unknown";
+  }
+}
+
 void SDI12Device::set_sdi12_address(std::string address) {
     this->address_ = address.c_str()[0];
     ESP_LOGI(TAG, "Set SDI12 Address '%c'", this->address_);
 }
 
+void SDI12Device::start_measurement_(MeasurementType type, SDI12MeasurementCallback &&callback, uint32_t delay_ms,
+                                     uint8_t index) {
+    if (this->measurement_callback_) {
+        ESP_LOGW(TAG, "SDI-12 device %c is still busy with the previous measurement", this->address_);
+        return;
+    }
+    this->measurement_callback_ = std::move(callback);
+    this->values_expected_ = 0;
+    this->values_received_ = 0;
+    this->values_valid_.reset();
+
+    SDI12Command command = this->command_(type == MeasurementType::CONCURRENT ? "C" : "M");
+    if (this->crc_)
+        command.push_back('C');
+    if (index > 0)
+        command.push_back('0' + index);
+    command.push_back('!');
+    this->send_command_(command, [this, type](SDI12Status status, std::string_view response) {
+        this->handle_measurement_started_(type, status, response);
+    }, delay_ms);
+}
+
+void SDI12Device::handle_measurement_started_(MeasurementType type, SDI12Status status, std::string_view response) {
+    if (status != SDI12Status::OK) {
+        this->finish_measurement_(status);
+        return;
+    }
 
-// Function to tokenize and parse the SDI-12 response containing a variable number of values
-void SDI12Device::parse_sdi12_values_(const std::string &response, std::vector<float*> values) {
-    size_t start = 0;
-    size_t index = 0;
+    // atttn<CR><LF> for aM!, atttnn<CR><LF> for aC!, the same with a CRC requested
+    size_t count_digits = type == MeasurementType::CONCURRENT ? 2 : 1;
+    if (response.length() != 6 + count_digits || response[0] != this->address_) {
+        ESP_LOGW(TAG, "Invalid measurement response from SDI-12 device %c: '%.*s'", this->address_,
+                 static_cast<int>(response.length()), response.data());
+        this->finish_measurement_(SDI12Status::INVALID_RESPONSE);
+        return;
+    }
 
-    while (start < response.length() && index < values.size()) {
-        // Find the next occurrence of '+' or '-', indicating the start of the next number
-        size_t end = response.find_first_of("+-", start + 1);
-        if (end == std::string::npos || index == values.size() - 1) {
-            end = response.length();
-        }
+    uint32_t wait_s = parse_number(response.substr(1, 3));
+    uint32_t count = parse_number(response.substr(4, count_digits));
+    if (count == 0) {
+        ESP_LOGW(TAG, "SDI-12 device %c has no values to measure", this->address_);
+        this->finish_measurement_(SDI12Status::INVALID_RESPONSE);
+        return;
+    }
+    ESP_LOGV(TAG, "SDI-12 device %c will have %u values ready in %u s", this->address_, count, wait_s);
+    this->values_expected_ = count;
 
-        // Extract the number (including its sign)
-        std::string token = response.substr(start, end - start);
+    // A sensor aborts an aM! measurement when it sees a break, so nobody else may talk
+    // until its data was read. With aC! the bus is free in the meantime.
+    if (type == MeasurementType::MEASURE)
+        this->bus_->reserve(this);
 
-        // Trim line endings if this is the last token
-        if (index == values.size() - 1) {
-            size_t pos = token.find_last_not_of("\r\n");
-            if (pos != std::string::npos) {
-                token = token.substr(0, pos + 1);
-            }
-        }
+    this->request_data_page_(0, wait_s * 1000);
 
-        // Convert token to float
-        std::istringstream converter(token);
-        converter >> *values[index];
-        if (converter.fail()) {
-            *values[index] = NAN; // Indicate a parsing error
-        }
+    // After aM! the sensor announces early data with a service request, ttt is the fallback
+    if (type == MeasurementType::MEASURE && wait_s > 0)
+        this->bus_->await_service_request(this);
+}
+
+void SDI12Device::request_data_page_(uint8_t page, uint32_t delay_ms) {
+    SDI12Command command = this->command_("D");
+    command.push_back('0' + page);
+    command.push_back('!');
+    this->send_command_(command, [this, page](SDI12Status status, std::string_view response) {
+        this->handle_data_page_(page, status, response);
+    }, delay_ms, this->data_format_());
+}
 
-        // Prepare for the next number
-        start = end;
-        ++index;
+void SDI12Device::handle_data_page_(uint8_t page, SDI12Status status, std::string_view response) {
+    if (status != SDI12Status::OK) {
+        this->finish_measurement_(status);
+        return;
+    }
+    if (response.empty() || response[0] != this->address_) {
+        ESP_LOGW(TAG, "Invalid data response from SDI-12 device %c: '%.*s'", this->address_,
+                 static_cast<int>(response.length()), response.data());
+        this->finish_measurement_(SDI12Status::INVALID_RESPONSE);
+        return;
     }
+
+    bool measure = this->bus_->has_performance_counters();
+    uint32_t perf_start = measure ? sdi12_cycle_count() : 0;
+    SDI12ParseResult result = sdi12_parse_values(response.substr(1), this->values_ + this->values_received_,
+                                                 this->values_expected_ - this->values_received_);
+    if (measure)
+        this->bus_->count_parse(perf_start);
+    size_t parsed = result.count;
+    for (size_t i = 0; i < parsed; i++)
+        this->values_valid_[this->values_received_ + i] = result.is_valid(i);
+    this->values_received_ += parsed;
+    if (this->values_received_ >= this->values_expected_) {
+        this->finish_measurement_(SDI12Status::OK);
+        return;
+    }
+    // A response without values means the sensor has no more, aD9! is the last page there is
+    if (parsed == 0 || page == 9) {
+        ESP_LOGW(TAG, "SDI-12 device %c sent only %u of %u values", this->address_, this->values_received_,
+                 this->values_expected_);
+        this->finish_measurement_(SDI12Status::OK);
+        return;
+    }
+    // The sensor just answered, so the next page goes out without a break
+    this->request_data_page_(page + 1, 0);
+}
+
+void SDI12Device::finish_measurement_(SDI12Status status) {
+    this->bus_->release(this);
+    SDI12MeasurementCallback callback = std::move(this->measurement_callback_);
+    if (callback)
+        callback(status, this->values_, this->values_received_, this->values_valid_);
+}
+
+void SDI12Device::read_continuous_(uint8_t index, SDI12Callback &&callback, uint32_t delay_ms) {
+    SDI12Command command = this->command_(this->crc_ ? "RC" : "R");
+    command.push_back('0' + index);
+    command.push_back('!');
+    this->send_command_(command, std::move(callback), delay_ms, this->data_format_());
+}
+
+void SDI12Device::start_binary_measurement_(SDI12BinaryCallback &&callback, uint32_t delay_ms) {
+    if (this->measurement_callback_ || this->binary_callback_) {
+        ESP_LOGW(TAG, "SDI-12 device %c is still busy with the previous measurement", this->address_);
+        return;
+    }
+    this->binary_callback_ = std::move(callback);
+
+    this->send_command_(this->command_("HB!"), [this](SDI12Status status, std::string_view response) {
+        this->handle_binary_started_(status, response);
+    }, delay_ms);
+}
+
+void SDI12Device::handle_binary_started_(SDI12Status status, std::string_view response) {
+    if (status != SDI12Status::OK) {
+        this->finish_binary_measurement_(status);
+        return;
+    }
+
+    // atttnnn<CR><LF>
+    if (response.length() != 9 || response[0] != this->address_) {
+        ESP_LOGW(TAG, "Invalid binary measurement response from SDI-12 device %c: '%.*s'", this->address_,
+                 static_cast<int>(response.length()), response.data());
+        this->finish_binary_measurement_(SDI12Status::INVALID_RESPONSE);
+        return;
+    }
+
+    uint32_t wait_s = parse_number(response.substr(1, 3));
+    uint32_t count = parse_number(response.substr(4, 3));
+    if (count == 0) {
+        ESP_LOGW(TAG, "SDI-12 device %c has no values to measure", this->address_);
+        this->finish_binary_measurement_(SDI12Status::INVALID_RESPONSE);
+        return;
+    }
+    ESP_LOGV(TAG, "SDI-12 device %c will have %u binary values ready in %u s", this->address_, count, wait_s);
+
+    // Like aC!, a high-volume measurement isn't aborted by a break, the bus stays free
+    this->binary_count_ = count;
+    this->binary_received_ = 0;
+    this->request_binary_page_(0, wait_s * 1000);
+}
+
+void SDI12Device::request_binary_page_(uint8_t page, uint32_t delay_ms) {
+    SDI12Command command = this->command_("DB");
+    command.push_back('0' + page);
+    command.push_back('!');
+    this->send_command_(command, [this, page](SDI12Status status, std::string_view response) {
+        this->handle_binary_page_(page, status, response);
+    }, delay_ms, SDI12ResponseFormat::BINARY);
+}
+
+void SDI12Device::handle_binary_page_(uint8_t page, SDI12Status status, std::string_view response) {
+    if (status != SDI12Status::OK) {
+        this->finish_binary_measurement_(status);
+        return;
+    }
+
+    SDI12BinaryPacket packet;
+    if (!packet.parse(response) || packet.address() != this->address_) {
+        ESP_LOGW(TAG, "Invalid binary packet %u from SDI-12 device %c", page, this->address_);
+        this->finish_binary_measurement_(SDI12Status::INVALID_RESPONSE);
+        return;
+    }
+
+    packet.first = this->binary_received_;
+    this->binary_received_ += packet.count();
+    // an empty packet means the sensor has nothing more, even if it announced more values
+    packet.last = this->binary_received_ >= this->binary_count_ || packet.count() == 0 || page == 9;
+    ESP_LOGV(TAG, "SDI-12 device %c sent %u binary values of %u", this->address_,
+             static_cast<unsigned>(this->binary_received_), static_cast<unsigned>(this->binary_count_));
+
+    if (packet.last) {
+        SDI12BinaryCallback callback = std::move(this->binary_callback_);
+        callback(SDI12Status::OK, packet);
+        return;
+    }
+    this->binary_callback_(SDI12Status::OK, packet);
+    this->request_binary_page_(page + 1, 0);
+}
+
+void SDI12Device::finish_binary_measurement_(SDI12Status status) {
+    SDI12BinaryCallback callback = std::move(this->binary_callback_);
+    SDI12BinaryPacket empty;
+    empty.last = true;
+    if (callback)
+        callback(status, empty);
+}
+
+void SDI12Device::start_streaming_(uint8_t index, SDI12Callback &&callback, uint32_t interval_ms) {
+    this->stream_callback_ = std::move(callback);
+    this->stream_index_ = index;
+    this->stream_interval_ = interval_ms;
+    this->streaming_ = true;
+    if (!this->stream_pending_)
+        this->stream_next_(0);
+}
+
+void SDI12Device::stream_next_(uint32_t delay_ms) {
+    this->stream_pending_ = true;
+    this->read_continuous_(this->stream_index_, [this](SDI12Status status, std::string_view response) {
+        this->stream_pending_ = false;
+        if (!this->streaming_)
+            return;
+        // These fail before the request was queued, queueing again would fail the same way
+        if (status == SDI12Status::BUSY || status == SDI12Status::NOT_INITIALIZED) {
+            ESP_LOGW(TAG, "Streaming from SDI-12 device %c stopped: %s", this->address_,
+                     sdi12_status_to_string(status));
+            this->streaming_ = false;
+        }
+        this->stream_callback_(status, response);
+        if (!this->streaming_)
+            return;
+        // a sensor that doesn't answer is asked again at a slower pace, not hogging the bus
+        this->stream_next_(status == SDI12Status::OK ? this->stream_interval_ : STREAM_RETRY_INTERVAL);
+    }, delay_ms);
 }
 
 
 
 void SDI12Bus::setup() {
   ESP_LOGD(TAG, "Setting up SDI-12 bus...");
-  this->SDI12_ = SDI12(this->rx_pin_->get_pin(), this->tx_pin_->get_pin(), this->oe_pin_->get_pin());
+  if (this->phy_ == &this->bitbang_phy_)
+    this->bitbang_phy_.set_pins(this->rx_pin_->get_pin(), this->tx_pin_->get_pin(), this->oe_pin_->get_pin());
+  this->phy_->setup();
+  this->phy_->set_performance_counters(this->performance_counters_);
+  // Every bus keeps its own line, it listens from now on except while transmitting
+  this->phy_->begin();
+  this->phy_->listen();
 
+  initialized_ = true;
+
+  // a scan started later on saves its result as well
+  if (this->topology_cache_)
+    this->topology_pref_ = global_preferences->make_preference<SDI12Topology>(this->topology_key_, true);
   if (this->scan_) {
-    this->init_scan_();
+    if (this->load_topology_()) {
+      this->begin_scan_();
+      this->verify_topology_(0);
+    } else {
+      this->start_scan();
+    }
   }
 
-  initialized_ = true;
+  this->statistics_started_ = millis();
+  this->set_interval("statistics", STATISTICS_INTERVAL, [this]() { this->log_statistics_(); });
 }
 
 void SDI12Bus::dump_config() {
@@ -70,133 +345,711 @@ void SDI12Bus::dump_config() {
   LOG_PIN("  RX Pin: ", this->rx_pin_);
   LOG_PIN("  TX Pin: ", this->tx_pin_);
   LOG_PIN("  OE Pin: ", this->oe_pin_);
+  ESP_LOGCONFIG(TAG, "  First Byte Timeout: %u ms", this->first_byte_timeout_us_ / 1000);
+  ESP_LOGCONFIG(TAG, "  Inter-Character Timeout: %u ms", this->char_timeout_us_ / 1000);
+  ESP_LOGCONFIG(TAG, "  Wake Time: %u ms", this->wake_time_);
+  ESP_LOGCONFIG(TAG, "  Adaptive Timing: %s", YESNO(this->adaptive_timing_));
+  ESP_LOGCONFIG(TAG, "  Retries: %u", this->retries_);
+  ESP_LOGCONFIG(TAG, "  Scan: %s", YESNO(this->scan_));
+  ESP_LOGCONFIG(TAG, "  Performance Counters: %s", YESNO(this->performance_counters_));
 }
 
-std::string SDI12Bus::send_command(std::string command) {
+void SDI12Bus::submit(SDI12Device *device, std::string_view command, SDI12Callback &&callback,
+                      uint32_t delay_ms, SDI12ResponseFormat format) {
   if (!initialized_) {
     ESP_LOGW(TAG, "SDI12 bus not initialized!");
-    return "";
+    callback(SDI12Status::NOT_INITIALIZED, "");
+    return;
   }
 
-  ESP_LOGV(TAG, "Sending command '%s' on SDI-12 bus...", command.c_str());
+  SDI12Request &request = device->request_;
+  if (request.pending) {
+    ESP_LOGW(TAG, "Command '%.*s' dropped, '%s' is still waiting for the bus", static_cast<int>(command.length()),
+             command.data(), request.command.c_str());
+    callback(SDI12Status::BUSY, "");
+    return;
+  }
+  if (!request.command.assign(command)) {
+    ESP_LOGW(TAG, "Command '%.*s' is longer than %u characters", static_cast<int>(command.length()), command.data(),
+             static_cast<unsigned>(SDI12_MAX_COMMAND));
+    callback(SDI12Status::INVALID_COMMAND, "");
+    return;
+  }
 
-  this->SDI12_.begin();
+  ESP_LOGV(TAG, "Queueing command '%s' on SDI-12 bus...", request.command.c_str());
+  request.callback = std::move(callback);
+  request.due = millis() + delay_ms;
+  request.format = format;
+  request.pending = true;
+}
 
-  this->SDI12_.sendCommand(command.c_str(), 100);
-  this->SDI12_.clearBuffer();
+SDI12Device *SDI12Bus::next_device_(uint32_t now) {
+  SDI12Device *next = nullptr;
+  int next_rank = INT_MIN;
 
-  delay(30);
+  for (auto *device : this->devices_) {
+    if (!device->request_.pending || static_cast<int32_t>(now - device->request_.due) < 0)
+      continue;
+    if (this->reserved_by_ != nullptr && device != this->reserved_by_)
+      continue;
+    int rank = device->priority_ + device->skipped_;
+    if (rank > next_rank) {
+      next = device;
+      next_rank = rank;
+    }
+  }
+  if (next == nullptr)
+    return nullptr;
+  // Aging alone would take some 130 rounds to lift a probe at the lowest priority above
+  // a device at 0, a device that streams would hold off the scan for minutes
+  if (next != this->discovery_ && this->discovery_ != nullptr && this->discovery_->skipped_ >= SCAN_SHARE - 1 &&
+      (this->reserved_by_ == nullptr || this->reserved_by_ == this->discovery_))
+    next = this->discovery_;
 
-  std::string buffer;
-  while (this->SDI12_.available()) {
-    char c = static_cast<char>(this->SDI12_.read());
-    buffer += c;
-    delay(10);  // 1 character ~ 7.5ms.
+  // Age the due requests that lose this round so that they win eventually
+  for (auto *device : this->devices_) {
+    if (device != next && device->request_.pending && static_cast<int32_t>(now - device->request_.due) >= 0 &&
+        device->skipped_ < UINT8_MAX)
+      device->skipped_++;
   }
+  next->skipped_ = 0;
+  return next;
+}
 
-  ESP_LOGV(TAG, "SDI-12 Received Response: %s", buffer.c_str());
+void SDI12Bus::set_state_(TransactionState state, uint32_t now) {
+  if (state != TransactionState::TRANSMIT && transmitting_ == this)
+    transmitting_ = nullptr;
+  this->state_ = state;
+  this->state_started_ = now;
+}
 
-  this->SDI12_.end();
-  return buffer;
+void SDI12Bus::restart_command_(uint32_t now) {
+  ESP_LOGV(TAG, "Command '%s' not sent in time, waking the sensors again", this->active_.command.c_str());
+  this->tx_in_one_go_ = true;
+  this->attempt_wake_ms_ = this->wake_time_;
+  this->break_skipped_ = false;
+  this->phy_->send_break();
+  this->set_state_(TransactionState::BREAK, now);
 }
 
-char SDI12Bus::read_char() {
-  if (!initialized_) {
-    ESP_LOGW(TAG, "SDI12 bus not initialized!");
-    return '\0';
+void SDI12Bus::start_transaction_(SDI12Device *device, uint32_t now) {
+  uint32_t latency = now - device->request_.due;
+  if (latency > this->max_latency_ms_)
+    this->max_latency_ms_ = latency;
+
+  this->active_ = std::move(device->request_);
+  this->active_device_ = device;
+  device->request_.pending = false;
+  this->service_request_from_ = nullptr;
+  this->high_freq_.start();
+  this->transaction_started_ = micros();
+  this->attempt_ = 0;
+
+  ESP_LOGV(TAG, "Sending command '%s' on SDI-12 bus...", this->active_.command.c_str());
+  this->start_attempt_();
+}
+
+void SDI12Bus::start_attempt_() {
+  this->response_.clear();
+  this->first_byte_after_ = 0;
+  this->attempt_overflowed_ = false;
+  this->tx_in_one_go_ = false;
+  this->attempt_counters_ = this->phy_->line_counters();
+
+  uint32_t now = micros();
+  this->attempt_wake_ms_ = this->device_wake_ms_(this->active_device_);
+  this->attempt_timeout_us_ = this->device_timeout_us_(this->active_device_);
+  this->break_skipped_ = this->can_skip_break_(now);
+  if (this->break_skipped_) {
+    this->breaks_skipped_++;
+    this->time_saved_us_ += SDI12_BREAK_US + this->wake_time_ * 1000;
+    this->phy_->send_marking();
+    this->set_state_(TransactionState::MARKING, now);
+  } else {
+    this->time_saved_us_ += (this->wake_time_ - this->attempt_wake_ms_) * 1000;
+    this->phy_->send_break();
+    this->set_state_(TransactionState::BREAK, now);
   }
 
-  ESP_LOGV(TAG, "Reading from SDI-12 bus...");
+  // The line is driven now, so the framing can change before the response
+  bool binary = this->active_.format == SDI12ResponseFormat::BINARY;
+  this->phy_->set_binary(binary);
+}
 
-  return '\0';
+const char *SDI12Bus::printable_response_() const {
+  return this->active_.format == SDI12ResponseFormat::BINARY ? "(binary packet)" : this->response_.c_str();
 }
 
-boolean SDI12Bus::check_device_active_(char i) {
-  String command = String(i) + "!";
+bool SDI12Bus::is_complete_() const {
+  if (this->active_.format != SDI12ResponseFormat::BINARY)
+    return has_terminator(this->response_);
+  // A size beyond the spec is garbage, the CRC check rejects the packet
+  int size = sdi12_binary_payload_size(this->response_);
+  if (size < 0)
+    return false;
+  return size > static_cast<int>(SDI12_BINARY_MAX_PAYLOAD) ||
+         this->response_.length() == SDI12_BINARY_HEADER_SIZE + size + SDI12_BINARY_CRC_SIZE;
+}
 
-  for (int j = 1; j <= 3; j++) {
-    unsigned long startTime = millis();
-    this->SDI12_.sendCommand(command, 20);
-    this->SDI12_.clearBuffer();
-    delay(20);
-    if (this->SDI12_.available()) {
-      return true;
+// A sensor stays awake while the line is active, but goes back to standby on a command
+// to another address. So the break can be left out if the last command went to the same
+// device, it answered, and the command will start within the activity window.
+bool SDI12Bus::can_skip_break_(uint32_t now) const {
+  if (this->active_.command.empty() || this->active_.command[0] != this->awake_address_)
+    return false;
+  return now - this->phy_->last_activity_time() + SDI12_MARKING_US < SDI12_ACTIVITY_WINDOW_US;
+}
+
+// The probes of a scan go to many addresses through one device, they keep the configured timing
+bool SDI12Bus::is_adaptive_(const SDI12Device *device) const {
+  return this->adaptive_timing_ && device != this->discovery_;
+}
+
+uint32_t SDI12Bus::device_wake_ms_(const SDI12Device *device) const {
+  if (!this->is_adaptive_(device))
+    return this->wake_time_;
+  return this->wake_time_ - std::min(device->timing_.wake_saved_ms, this->wake_time_);
+}
+
+uint32_t SDI12Bus::device_timeout_us_(const SDI12Device *device) const {
+  const SDI12Timing &timing = device->timing_;
+  if (!this->is_adaptive_(device) || timing.samples < LATENCY_SAMPLES)
+    return this->first_byte_timeout_us_;
+  return std::min(timing.latency_us + LATENCY_MARGIN_US, this->first_byte_timeout_us_);
+}
+
+bool SDI12Bus::learn_timing_() {
+  SDI12Device *device = this->active_device_;
+  SDI12Timing &timing = device->timing_;
+  bool adaptive = this->is_adaptive_(device);
+
+  if (!this->response_.empty()) {
+    if (!adaptive)
+      return false;
+    // the first character is only decoded once its stop bit has passed
+    uint32_t latency = this->first_byte_after_ > SDI12_CHARACTER_US ? this->first_byte_after_ - SDI12_CHARACTER_US : 0;
+    timing.latency_us = std::max(latency, timing.latency_us - timing.latency_us / 16);
+    if (timing.samples < LATENCY_SAMPLES)
+      timing.samples++;
+    // the device woke in time, see whether it manages with less
+    if (!this->break_skipped_) {
+      timing.wake_saved_ms =
+          std::min({timing.wake_saved_ms + WAKE_STEP_MS, timing.wake_saved_limit_ms, this->wake_time_});
     }
+    return false;
   }
-  this->SDI12_.clearBuffer();
-  return false;
+
+  // Nothing at all came back. Unless the device got the full configured timing, that is
+  // the first suspect, so the device starts over from it.
+  bool woken_short = this->break_skipped_ || this->attempt_wake_ms_ < this->wake_time_;
+  if (!woken_short && this->attempt_timeout_us_ >= this->first_byte_timeout_us_)
+    return false;
+  if (adaptive) {
+    if (!this->break_skipped_ && this->attempt_wake_ms_ < this->wake_time_) {
+      uint32_t wake_floor = this->attempt_wake_ms_ + WAKE_MARGIN_MS;
+      timing.wake_saved_limit_ms = wake_floor < this->wake_time_ ? this->wake_time_ - wake_floor : 0;
+    }
+    timing.wake_saved_ms = 0;
+    timing.latency_us = 0;
+    timing.samples = 0;
+    timing.misses++;
+  }
+  // Either way the command is sent again right away with the configured timing. A device
+  // that was awake but slower than its learned timeout would otherwise lose the reading.
+  return true;
 }
 
-std::string SDI12Bus::get_device_info_(char i)
-{
-  String command = String(i) + "I!";
-  this->SDI12_.sendCommand(command);
-  this->SDI12_.clearBuffer();
-  delay(30);
+void SDI12Bus::process_transaction_() {
+  uint32_t now = micros();
+
+  switch (this->state_) {
+    case TransactionState::BREAK:
+      if (now - this->state_started_ < SDI12_BREAK_US + this->attempt_wake_ms_ * 1000)
+        return;
+      this->phy_->send_marking();
+      this->set_state_(TransactionState::MARKING, now);
+      return;
 
-  std::string buffer = "";
-  while (this->SDI12_.available()) {
-    char c = static_cast<char>(this->SDI12_.read());
-    buffer += c;
-    delay(10);  // 1 character ~ 7.5ms.
+    case TransactionState::MARKING:
+      if (now - this->state_started_ < SDI12_MARKING_US)
+        return;
+      this->tx_index_ = 0;
+      this->set_state_(TransactionState::TRANSMIT, now);
+      // fall through
+
+    case TransactionState::TRANSMIT: {
+      // A character takes 8.3 ms, so the command goes out one per loop() to let the other
+      // components run in between. The next one has to follow within 1.66 ms though, a
+      // command that was held up is sent again after a new break, in one go this time.
+      const SDI12Command &command = this->active_.command;
+      if (this->tx_index_ == 0) {
+        // another bus sending its command would hold up ours, the line stays marking meanwhile
+        if (transmitting_ != nullptr && transmitting_ != this) {
+          if (now - this->state_started_ + SDI12_MARKING_US >= SDI12_ACTIVITY_WINDOW_US)
+            this->restart_command_(now);
+          return;
+        }
+      } else if (now - this->tx_last_ > SDI12_CHARACTER_GAP_US) {
+        this->restart_command_(now);
+        return;
+      }
+      transmitting_ = this;
+      do {
+        this->phy_->send_char(command[this->tx_index_++]);
+      } while (this->tx_in_one_go_ && this->tx_index_ < command.length());
+      this->tx_last_ = micros();
+      if (this->tx_index_ < command.length())
+        return;
+      this->phy_->end_frame();
+      this->set_state_(TransactionState::AWAIT_FIRST_BYTE, micros());
+      return;
+    }
+
+    case TransactionState::AWAIT_FIRST_BYTE: {
+      // Characters only show up once decoded, so the first one is due a character time
+      // after the timeout for the start of the response.
+      int available = this->phy_->available();
+      if (available < 0) {
+        // Characters were lost, the response can't be complete: it is asked for again
+        // right away instead of waiting out the timeout and reporting no response.
+        this->attempt_overflowed_ = true;
+        this->phy_->clear();
+        this->set_state_(TransactionState::TIMEOUT, now);
+        this->finish_transaction_();
+        return;
+      }
+      if (available == 0) {
+        if (now - this->state_started_ >= this->attempt_timeout_us_ + SDI12_CHARACTER_US) {
+          this->time_saved_us_ += this->first_byte_timeout_us_ - this->attempt_timeout_us_;
+          this->set_state_(TransactionState::TIMEOUT, now);
+          this->finish_transaction_();
+        }
+        return;
+      }
+      this->first_byte_after_ = now - this->state_started_;
+      this->set_state_(TransactionState::RECEIVE, now);
+    }
+      // fall through
+
+    case TransactionState::RECEIVE: {
+      uint8_t chunk[16];
+      size_t length;
+      while ((length = this->phy_->read(chunk, sizeof(chunk))) > 0) {
+        this->last_char_ = this->phy_->last_receive_time();
+        for (size_t i = 0; i < length; i++) {
+          if (!this->response_.push_back(static_cast<char>(chunk[i]))) {
+            // nothing this long is valid, it is treated like a truncated response
+            ESP_LOGW(TAG, "SDI-12 response to '%s' exceeds %u bytes", this->active_.command.c_str(),
+                     static_cast<unsigned>(SDI12_MAX_RESPONSE));
+            this->set_state_(TransactionState::TIMEOUT, now);
+            this->finish_transaction_();
+            return;
+          }
+          if (this->is_complete_()) {
+            this->set_state_(TransactionState::DONE, now);
+            this->finish_transaction_();
+            return;
+          }
+        }
+      }
+      // the last character may have completed after now was taken
+      int32_t since_last_char = now - this->last_char_;
+      if (since_last_char >= static_cast<int32_t>(SDI12_CHARACTER_US + this->char_timeout_us_)) {
+        ESP_LOGW(TAG, "SDI-12 response to '%s' incomplete: '%s'", this->active_.command.c_str(),
+                 this->printable_response_());
+        this->set_state_(TransactionState::TIMEOUT, now);
+        this->finish_transaction_();
+      }
+      return;
+    }
+
+    default:
+      return;
   }
+}
 
-  if (!buffer.empty()) {
-    ESP_LOGD(TAG, "SDI-12 device %c info: %s", i, buffer.c_str());
+void SDI12Bus::finish_transaction_() {
+  SDI12LineCounters counters = this->phy_->line_counters();
+  this->line_errors_ = SDI12_LINE_OK;
+  if (counters.parity_errors != this->attempt_counters_.parity_errors)
+    this->line_errors_ |= SDI12_PARITY_ERROR;
+  if (counters.framing_errors != this->attempt_counters_.framing_errors)
+    this->line_errors_ |= SDI12_FRAMING_ERROR;
+  if (counters.overflows != this->attempt_counters_.overflows || this->attempt_overflowed_)
+    this->line_errors_ |= SDI12_OVERFLOW_ERROR;
+  this->awake_address_ = this->response_.empty() ? '\0' : this->active_.command[0];
+
+  // The sensor may have been asleep after a skipped break or a shortened wake time, or
+  // slower than its learned timeout. Repeating the command with the configured timing
+  // doesn't count as a retry. Lost characters are
+  // no sign of a sleeping sensor.
+  if (!this->attempt_overflowed_ && this->learn_timing_()) {
+    ESP_LOGD(TAG, "No response to SDI-12 command '%s' with the learned timing, repeating it with the configured one",
+             this->active_.command.c_str());
+    this->start_attempt_();
+    return;
+  }
+
+  // A complete response with a CRC is only passed on if it matches, without the CRC
+  bool crc_error = false;
+  if (this->state_ == TransactionState::DONE && this->active_.format != SDI12ResponseFormat::TEXT) {
+    uint32_t perf_start = this->performance_counters_ ? sdi12_cycle_count() : 0;
+    if (this->active_.format == SDI12ResponseFormat::TEXT_CRC) {
+      crc_error = !sdi12_check_crc(this->response_);
+    } else if (this->active_.format == SDI12ResponseFormat::BINARY) {
+      crc_error = !sdi12_check_binary_crc(this->response_);
+    }
+    if (this->performance_counters_)
+      this->perf_.crc.add(perf_start);
+  }
+  if (crc_error)
+    this->crc_errors_++;
+
+  // A corrupted or truncated response is asked for again right away, rather than
+  // handing out bad data or waiting for the next poll.
+  bool truncated = this->state_ == TransactionState::TIMEOUT && !this->response_.empty();
+  if ((this->line_errors_ != SDI12_LINE_OK || truncated || crc_error) && this->attempt_ < this->retries_) {
+    this->attempt_++;
+    this->retry_count_++;
+    ESP_LOGD(TAG, "Retrying SDI-12 command '%s' (line errors 0x%02X%s, response '%s')",
+             this->active_.command.c_str(), this->line_errors_, crc_error ? ", CRC mismatch" : "",
+             this->printable_response_());
+    this->start_attempt_();
+    return;
+  }
+
+  SDI12Status status = SDI12Status::OK;
+  if (this->state_ == TransactionState::TIMEOUT && !this->attempt_overflowed_) {
+    if (this->response_.empty() && this->active_device_ == this->discovery_) {
+      ESP_LOGV(TAG, "No response to SDI-12 probe '%s'", this->active_.command.c_str());
+    } else if (this->response_.empty()) {
+      ESP_LOGW(TAG, "No response to SDI-12 command '%s'", this->active_.command.c_str());
+    }
+    status = SDI12Status::TIMEOUT;
+  } else if (this->line_errors_ != SDI12_LINE_OK) {
+    ESP_LOGW(TAG, "SDI-12 response to '%s' corrupted (line errors 0x%02X): '%s'", this->active_.command.c_str(),
+             this->line_errors_, this->printable_response_());
+    status = SDI12Status::LINE_ERROR;
+  } else if (crc_error) {
+    ESP_LOGW(TAG, "SDI-12 response to '%s' failed its CRC: '%s'", this->active_.command.c_str(),
+             this->printable_response_());
+    status = SDI12Status::CRC_ERROR;
   } else {
-    ESP_LOGD(TAG, "SDI-12 device %c respond without info.", i);
-    return "No device info";
+    ESP_LOGV(TAG, "SDI-12 Received Response: %s", this->printable_response_());
+  }
+  if (this->active_.format == SDI12ResponseFormat::BINARY)
+    this->phy_->set_binary(false);
+  this->state_ = TransactionState::IDLE;
+  this->high_freq_.stop();
+
+  this->last_duration_us_ = micros() - this->transaction_started_;
+  this->busy_us_ += this->last_duration_us_;
+  ESP_LOGV(TAG, "SDI-12 transaction '%s' took %.1f ms, response started after %.1f ms",
+           this->active_.command.c_str(), this->last_duration_us_ / 1000.0f, this->first_byte_after_ / 1000.0f);
+
+  // the callback may queue a follow-up command right away
+  SDI12Callback callback = std::move(this->active_.callback);
+  callback(status, this->response_);
+}
+
+bool SDI12Bus::is_configured_(char address) const {
+  for (auto *device : this->devices_) {
+    if (device != this->discovery_ && device->address_ == address)
+      return true;
   }
-  return buffer;
+  return false;
 }
 
-void SDI12Bus::init_scan_() {
+// A device acknowledging a! or ?! answers a<CR><LF>
+static bool is_acknowledge(std::string_view response) {
+  return response.length() == 3 && std::isalnum(static_cast<unsigned char>(response[0])) &&
+         has_terminator(response);
+}
+
+void SDI12Bus::start_scan() {
+  if (this->scanning_)
+    return;
+  this->begin_scan_();
+  this->discover_();
+}
+
+void SDI12Bus::begin_scan_() {
+  if (this->discovery_ == nullptr) {
+    this->discovery_ = new SDI12Device();  // NOLINT(cppcoreguidelines-owning-memory)
+    this->discovery_->set_sdi12_priority(INT8_MIN);
+    this->discovery_->set_sdi12_bus(this);
+  }
+  this->scanning_ = true;
+  this->scan_started_ = millis();
+  this->scan_probes_ = 0;
+  this->scan_results_.clear();
+}
+
+void SDI12Bus::discover_() {
   ESP_LOGD(TAG, "Scanning for devices on SDI-12 bus...");
 
-  // Create a vector that contains all addresses that should be scanned
+  // Every address that no configured device uses: 0-9, a-z, A-Z
+  this->addresses_to_scan_.clear();
+  size_t configured = 0;
+  for (const char *range : {"09", "az", "AZ"}) {
+    for (char address = range[0]; address <= range[1]; address++) {
+      if (this->is_configured_(address)) {
+        configured++;
+      } else {
+        this->addresses_to_scan_.push_back(address);
+      }
+    }
+  }
+
+  // ?! is answered by every device, it only gives a readable answer if there is just one
+  if (configured <= 1) {
+    this->probe_("?!", [this](SDI12Status status, std::string_view response) {
+      this->handle_wildcard_probe_(status, response);
+    });
+  } else {
+    this->scan_next_();
+  }
+}
+
+void SDI12Bus::probe_(std::string_view command, SDI12Callback &&callback) {
+  this->scan_probes_++;
+  this->discovery_->send_command_(command, std::move(callback));
+}
+
+void SDI12Bus::handle_wildcard_probe_(SDI12Status status, std::string_view response) {
+  if (status == SDI12Status::TIMEOUT && response.empty()) {
+    // nobody there
+    this->finish_scan_();
+    return;
+  }
+  if (status != SDI12Status::OK || !is_acknowledge(response)) {
+    ESP_LOGD(TAG, "Several SDI-12 devices answered ?!, probing each address");
+    this->scan_next_();
+    return;
+  }
+
+  char address = response[0];
+  ESP_LOGD(TAG, "Single SDI-12 device answered ?! with address %c", address);
   this->addresses_to_scan_.clear();
-  // Add numerical addresses
-  for (char i = '0'; i <= '9'; i++)
-    this->addresses_to_scan_.push_back(i);
-  // Add lowercase alphabetical addresses
-  for (char i = 'a'; i <= 'z'; i++)
-    this->addresses_to_scan_.push_back(i);
-  // Add uppercase alphabetical addresses
-  for (char i = 'A'; i <= 'Z'; i++)
-    this->addresses_to_scan_.push_back(i);
-}
-
-void SDI12Bus::do_scan_() {
+  if (this->is_configured_(address)) {
+    this->finish_scan_();
+  } else {
+    this->query_info_(address);
+  }
+}
+
+void SDI12Bus::scan_next_() {
+  if (this->addresses_to_scan_.empty()) {
+    this->finish_scan_();
+    return;
+  }
   char address = this->addresses_to_scan_.front();
   this->addresses_to_scan_.erase(this->addresses_to_scan_.begin());
 
   ESP_LOGV(TAG, "Scanning address %c", address);
-  this->SDI12_.begin();
-  if (this->check_device_active_(address)) {
-    std::string device_info = this->get_device_info_(address);
-    // Explicitly copy the string before placing it in the vector
-    this->scan_results_.emplace_back(address, std::string(device_info));
+  const char command[] = {address, '!'};
+  this->probe_({command, sizeof(command)}, [this, address](SDI12Status status, std::string_view response) {
+    if (status == SDI12Status::OK && is_acknowledge(response) && response[0] == address) {
+      this->query_info_(address);
+    } else {
+      this->scan_next_();
+    }
+  });
+}
+
+void SDI12Bus::query_info_(char address) {
+  const char command[] = {address, 'I', '!'};
+  this->probe_({command, sizeof(command)}, [this, address](SDI12Status status, std::string_view response) {
+    std::string info = "No device info";
+    if (status == SDI12Status::OK && response.length() > 3)
+      info = std::string(response.substr(1, response.length() - 3));
+    ESP_LOGD(TAG, "SDI-12 device %c info: %s", address, info.c_str());
+    this->scan_results_.emplace_back(address, info);
+    this->scan_next_();
+  });
+}
+
+void SDI12Bus::finish_scan_() {
+  this->scanning_ = false;
+  this->scan_duration_ms_ = millis() - this->scan_started_;
+  if (this->topology_cache_)
+    this->save_topology_();
+  ESP_LOGI(TAG, "SDI-12 bus scan finished after %u ms and %u probes! Results:", this->scan_duration_ms_,
+           this->scan_probes_);
+
+  if (this->scan_results_.empty()) {
+    ESP_LOGW(TAG, "Found no unconfigured SDI-12 devices!");
+  } else {
+    for (const auto &s : this->scan_results_) {
+      ESP_LOGI(TAG, "Found SDI-12 device at address %c: %s", s.first, s.second.c_str());
+    }
   }
-  this->SDI12_.end();
+}
 
-  if (this->addresses_to_scan_.empty()) {
-    ESP_LOGI(TAG, "SDI-12 bus scan finished! Results:");
-    this->scan_ = false;
+bool SDI12Bus::load_topology_() {
+  if (!this->topology_cache_)
+    return false;
+  // A record without devices is a scan that found only the configured ones, also a hit
+  if (!this->topology_pref_.load(&this->topology_) || this->topology_.count > SDI12_TOPOLOGY_SIZE) {
+    this->topology_ = {};
+    return false;
+  }
+  this->topology_loaded_ = true;
+  return true;
+}
 
-    if (scan_results_.empty()) {
-      ESP_LOGW(TAG, "Found no SDI-12 devices!");
+void SDI12Bus::verify_topology_(size_t index) {
+  if (index == this->topology_.count) {
+    for (size_t i = 0; i < this->topology_.count; i++)
+      this->scan_results_.emplace_back(this->topology_.devices[i].address, this->topology_.devices[i].info);
+    if (this->topology_.count == 0) {
+      ESP_LOGD(TAG, "The cached SDI-12 topology has no unconfigured devices, skipping the scan");
     } else {
-      for (const auto &s : scan_results_) {
-          ESP_LOGI(TAG, "Found SDI-12 device at address %c: %s", s.first, s.second.c_str());
-      }
+      ESP_LOGD(TAG, "All %u cached SDI-12 devices answered", this->topology_.count);
+    }
+    this->finish_scan_();
+    return;
+  }
+
+  char address = this->topology_.devices[index].address;
+  const char command[] = {address, '!'};
+  this->probe_({command, sizeof(command)}, [this, index, address](SDI12Status status, std::string_view response) {
+    if (status == SDI12Status::OK && is_acknowledge(response) && response[0] == address) {
+      this->verify_topology_(index + 1);
+    } else {
+      ESP_LOGI(TAG, "Cached SDI-12 device %c did not answer, rescanning the bus", address);
+      this->discover_();
+    }
+  });
+}
+
+void SDI12Bus::save_topology_() {
+  SDI12Topology topology{};
+  for (const auto &result : this->scan_results_) {
+    if (topology.count == SDI12_TOPOLOGY_SIZE) {
+      ESP_LOGW(TAG, "Only the first %u SDI-12 devices are cached", SDI12_TOPOLOGY_SIZE);
+      break;
     }
+    auto &device = topology.devices[topology.count++];
+    device.address = result.first;
+    strncpy(device.info, result.second.c_str(), SDI12_INFO_LENGTH);
+  }
+  // both are zero-initialized before they are filled, so unused bytes compare equal; a
+  // scan without results is saved as well, unless flash already says so
+  if (this->topology_loaded_ && memcmp(&topology, &this->topology_, sizeof(topology)) == 0)
+    return;
+
+  if (this->topology_pref_.save(&topology)) {
+    this->topology_ = topology;
+    this->topology_loaded_ = true;
+    ESP_LOGD(TAG, "Cached %u SDI-12 devices", topology.count);
   }
 }
 
+void SDI12Bus::await_service_request(SDI12Device *device) {
+  this->service_request_from_ = device;
+  this->service_request_.clear();
+  this->phy_->clear();
+}
+
+void SDI12Bus::poll_service_request_(uint32_t now) {
+  SDI12Device *device = this->service_request_from_;
+
+  uint8_t c;
+  while (this->phy_->read(&c, 1) > 0) {
+    // a<CR><LF> is all we wait for, drop whatever noise came before
+    if (this->service_request_.length() == 3)
+      this->service_request_.erase(0, 1);
+    this->service_request_.push_back(static_cast<char>(c));
+    if (!has_terminator(this->service_request_))
+      continue;
+    if (this->service_request_.length() == 3 && this->service_request_[0] == device->address_) {
+      ESP_LOGV(TAG, "Service request from SDI-12 device %c, data ready %d ms early", device->address_,
+               static_cast<int32_t>(device->request_.due - now));
+      device->request_.due = now;
+      this->service_request_from_ = nullptr;
+      return;
+    }
+    this->service_request_.clear();
+  }
+}
+
+// The calls of one hot path since the last statistics, their mean time and the longest since boot
+static void log_perf_counter(const char *name, const SDI12PerfCounter &counter, const SDI12PerfCounter &reported) {
+  uint32_t calls = counter.calls - reported.calls;
+  if (calls == 0)
+    return;
+  float cycles_per_us = sdi12_cycles_per_us();
+  ESP_LOGD(TAG, "SDI-12 %s: %u calls, %.2f us mean, %.2f us max", name, calls,
+           (counter.cycles - reported.cycles) / (calls * cycles_per_us), counter.max_cycles / cycles_per_us);
+}
+
+SDI12PerfCounters SDI12Bus::get_performance_counters() const {
+  SDI12PerfCounters counters = this->perf_;
+  this->phy_->rx_performance_counters(counters);
+  return counters;
+}
+
+void SDI12Bus::log_statistics_() {
+  uint32_t now = millis();
+  uint32_t elapsed = now - this->statistics_started_;
+  if (elapsed > 0) {
+    ESP_LOGD(TAG, "SDI-12 bus utilization %.1f%%, worst queueing latency %u ms, %.1f ms saved by the wake-up timing",
+             this->busy_us_ / (elapsed * 10.0f), this->max_latency_ms_,
+             (this->time_saved_us_ - this->reported_time_saved_us_) / 1000.0f);
+  }
+  this->reported_time_saved_us_ = this->time_saved_us_;
+  for (auto *device : this->devices_) {
+    if (!this->is_adaptive_(device))
+      continue;
+    const SDI12Timing &timing = device->timing_;
+    ESP_LOGD(TAG, "SDI-12 device %c: wake time %u ms, response latency %.1f ms, first byte timeout %.1f ms, %u misses",
+             device->address_, this->device_wake_ms_(device), timing.latency_us / 1000.0f,
+             this->device_timeout_us_(device) / 1000.0f, timing.misses);
+  }
+  SDI12LineCounters counters = this->phy_->line_counters();
+  uint32_t parity_errors = counters.parity_errors - this->reported_counters_.parity_errors;
+  uint32_t framing_errors = counters.framing_errors - this->reported_counters_.framing_errors;
+  uint32_t overflows = counters.overflows - this->reported_counters_.overflows;
+  if (parity_errors != 0 || framing_errors != 0 || overflows != 0) {
+    ESP_LOGW(TAG, "SDI-12 line errors: %u parity, %u framing, %u overflows (%u retries, %u CRC errors since boot)",
+             parity_errors, framing_errors, overflows, this->retry_count_, this->crc_errors_);
+  }
+  this->reported_counters_ = counters;
+  if (this->performance_counters_) {
+    SDI12PerfCounters perf = this->get_performance_counters();
+    log_perf_counter("Rx interrupt", perf.rx_interrupt, this->reported_perf_.rx_interrupt);
+    log_perf_counter("edge decoding", perf.rx_decode, this->reported_perf_.rx_decode);
+    log_perf_counter("transaction loop", perf.transaction, this->reported_perf_.transaction);
+    log_perf_counter("CRC check", perf.crc, this->reported_perf_.crc);
+    log_perf_counter("value parsing", perf.parse, this->reported_perf_.parse);
+    this->reported_perf_ = perf;
+  }
+  this->busy_us_ = 0;
+  this->max_latency_ms_ = 0;
+  this->statistics_started_ = now;
+}
+
 void SDI12Bus::loop() {
-  if (!this->addresses_to_scan_.empty()) {
-    this->do_scan_();
+  if (this->state_ != TransactionState::IDLE) {
+    uint32_t perf_start = this->performance_counters_ ? sdi12_cycle_count() : 0;
+    this->process_transaction_();
+    if (this->performance_counters_)
+      this->perf_.transaction.add(perf_start);
+    return;
+  }
+
+  uint32_t now = millis();
+  if (this->service_request_from_ != nullptr) {
+    this->poll_service_request_(now);
+  } else {
+    // nothing is expected while idle, drop what the line picked up
+    this->phy_->clear();
   }
+
+  SDI12Device *device = this->next_device_(now);
+  if (device != nullptr)
+    this->start_transaction_(device, now);
 }
 
 }  // namespace sdi12
@@ -1,45 +1,329 @@
 #pragma once
 
+#include <bitset>
+#include <functional>
 #include <vector>
 #include "esphome/core/component.h"
 #include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
 #include "esphome/core/component.h"
-#include "sdi12_bus.h"
+#include "esphome/core/preferences.h"
+#include "sdi12_binary.h"
+#include "sdi12_buffer.h"
+#include "sdi12_crc.h"
+#include "sdi12_perf.h"
+#include "sdi12_phy.h"
+#include "sdi12_phy_bitbang.h"
+#include "sdi12_stream.h"
+#include "sdi12_values.h"
 
 namespace esphome {
 namespace sdi12 {
 
 #define LOG_SDI12_DEVICE(this) ESP_LOGCONFIG(TAG, "  Address: %c", this->address_);
 
+/// Outcome of a transaction, handed to its completion callback.
+enum class SDI12Status : uint8_t {
+  OK = 0,
+  TIMEOUT,
+  NOT_INITIALIZED,
+  BUSY,
+  INVALID_RESPONSE,
+  LINE_ERROR,  ///< parity, framing or overflow errors persisted through all retries
+  CRC_ERROR,   ///< the CRC of the response didn't match through all retries
+  INVALID_COMMAND,  ///< the command doesn't fit the command buffer
+};
+
+const char *sdi12_status_to_string(SDI12Status status);
+
+/// The phases a single command/response transaction passes through in SDI12Bus::loop().
+enum class TransactionState : uint8_t {
+  IDLE = 0,
+  BREAK,             ///< data line held spacing to wake the sensors
+  MARKING,           ///< data line held marking before the command
+  TRANSMIT,          ///< command characters are sent, one per loop()
+  AWAIT_FIRST_BYTE,  ///< listening, nothing received yet
+  RECEIVE,           ///< response characters are arriving
+  DONE,              ///< response complete, callback pending
+  TIMEOUT,           ///< no response, callback pending
+};
+
+/// Receives the response, a view of the receive buffer of the bus valid within the callback
+using SDI12Callback = std::function<void(SDI12Status status, std::string_view response)>;
+/// The most values a measurement can announce, aC! and aCC! count them with two digits
+static const size_t SDI12_MAX_VALUES = 99;
+/// Bit i is set if value i of a measurement is a number
+using SDI12ValidValues = std::bitset<SDI12_MAX_VALUES>;
+/// Receives the @p count values of a measurement, NAN where one couldn't be parsed and its bit in @p valid clear
+using SDI12MeasurementCallback =
+    std::function<void(SDI12Status status, const float *values, size_t count, const SDI12ValidValues &valid)>;
+/// Receives each packet of a binary measurement, or an empty last one if it failed.
+using SDI12BinaryCallback = std::function<void(SDI12Status status, const SDI12BinaryPacket &packet)>;
+
+/// How the response to a command ends and is checked.
+enum class SDI12ResponseFormat : uint8_t {
+  TEXT = 0,  ///< characters up to <CR><LF>
+  TEXT_CRC,  ///< the same with a CRC before the <CR><LF>, checked and removed before the callback
+  BINARY,    ///< a binary packet as long as its header tells, its CRC is checked and removed
+};
+
+/// Measurement commands handled by SDI12Device::start_measurement_().
+enum class MeasurementType : uint8_t {
+  MEASURE = 0,  ///< aM!, nothing else may be addressed on the bus until the data was read
+  CONCURRENT,   ///< aC!, the bus is free for other devices while the sensor converts
+};
+
+/// A command waiting for its turn on the bus, one slot per device.
+struct SDI12Request {
+  SDI12Command command;
+  SDI12Callback callback;
+  uint32_t due{0};  ///< millis() from which on the request may be started
+  SDI12ResponseFormat format{SDI12ResponseFormat::TEXT};
+  bool pending{false};
+};
+
+/**
+ * The timing the bus learned for a device. The wake time is lowered step by step while
+ * the device answers and raised above the failing value after a miss, the first byte
+ * timeout follows the slowest recent response.
+ */
+struct SDI12Timing {
+  /// wake time below the configured one the device gets
+  uint32_t wake_saved_ms{0};
+  /// how far wake_saved_ms may grow, lowered after a miss
+  uint32_t wake_saved_limit_ms{UINT32_MAX};
+  /// longest recent time from the end of a command to the first start bit, decays slowly
+  uint32_t latency_us{0};
+  /// responses latency_us is based on, the configured timeout holds until there are enough
+  uint8_t samples{0};
+  /// commands that went unanswered with the learned timing and were repeated
+  uint32_t misses{0};
+};
+
+/// Longest aI! identification kept, 33 characters after the address per spec
+static const size_t SDI12_INFO_LENGTH = 33;
+/// Devices remembered by the topology cache of a bus
+static const uint8_t SDI12_TOPOLOGY_SIZE = 8;
+
+/// The devices found by the last scan, as stored in the preferences.
+struct SDI12Topology {
+  uint8_t count;
+  struct {
+    char address;
+    char info[SDI12_INFO_LENGTH + 1];
+  } devices[SDI12_TOPOLOGY_SIZE];
+};
+
+class SDI12Device;
+
 class SDI12Bus : public Component {
  public:
+  ~SDI12Bus() {
+    if (transmitting_ == this)
+      transmitting_ = nullptr;
+  }
   void setup() override;
   void dump_config() override;
-  std::string send_command(std::string command);
-  char read_char();
+  /// Add a device to the scheduler, called by SDI12Device::set_sdi12_bus().
+  void register_device(SDI12Device *device) { this->devices_.push_back(device); }
+  /**
+   * Queue a command for @p device, eligible after @p delay_ms. Among the due requests the
+   * scheduler starts the one of the highest priority, devices that were passed over gain
+   * priority until they are served. The transaction is driven from loop() without
+   * blocking, @p callback receives the response once it is complete or has timed out.
+   */
+  void submit(SDI12Device *device, std::string_view command, SDI12Callback &&callback, uint32_t delay_ms = 0,
+              SDI12ResponseFormat format = SDI12ResponseFormat::TEXT);
+  /// Keep all other devices off the bus until @p device releases it, as required during aM!
+  void reserve(SDI12Device *device) { this->reserved_by_ = device; }
+  void release(SDI12Device *device) {
+    if (this->reserved_by_ == device)
+      this->reserved_by_ = nullptr;
+  }
+  /**
+   * Listen for the service request of @p device while the bus is idle. Once the sensor
+   * reports its data ready, the pending request of @p device becomes due right away
+   * instead of at its scheduled time.
+   */
+  void await_service_request(SDI12Device *device);
   float get_setup_priority() const override { return setup_priority::BUS; }
+  /// discover the devices on the bus after boot
   void set_scan(bool scan) { scan_ = scan; }
+  /**
+   * Discover the devices on the bus in the background. Probes go through the scheduler
+   * at the lowest priority, so they use the bus time the configured devices leave free,
+   * and at least one transaction in eight on a busy bus. A single device is found with one ?! query, otherwise every address that
+   * isn't configured is probed with a!, and devices that answer with aI!.
+   */
+  void start_scan();
+  /**
+   * Remember the scan results in flash under @p key. At the next boot each cached device
+   * is checked with a single a! instead of scanning the whole bus, a full scan only runs
+   * if one of them is gone. A scan that found nothing besides the configured devices is
+   * remembered too, the next boot doesn't probe at all.
+   */
+  void set_topology_cache(const std::string &key) {
+    this->topology_key_ = fnv1_hash("sdi12_topology_" + key);
+    this->topology_cache_ = true;
+  }
   void set_tx_pin(InternalGPIOPin *tx_pin) { this->tx_pin_ = tx_pin; }
   void set_rx_pin(InternalGPIOPin *rx_pin) { this->rx_pin_ = rx_pin; }
   void set_oe_pin(InternalGPIOPin *oe_pin) { this->oe_pin_ = oe_pin; }
-  bool is_scanning() { return this->scan_; }
+  /// only record Rx transitions in the interrupt and decode them in the main loop
+  void set_deferred_decoding(bool deferred_decoding) { this->bitbang_phy_.set_deferred_decoding(deferred_decoding); }
+  /// drive the line through @p phy instead of bit-banging the pins
+  void set_phy(SDI12Phy *phy) { this->phy_ = phy; }
+  /// time from the end of a command to the start of the response, 15 ms per spec
+  void set_first_byte_timeout(uint32_t timeout_ms) { this->first_byte_timeout_us_ = timeout_ms * 1000; }
+  /// marking allowed between two characters of a response, 1.66 ms per spec
+  void set_inter_character_timeout(uint32_t timeout_ms) { this->char_timeout_us_ = timeout_ms * 1000; }
+  /// additional time the break is held for the sensors to wake, at most 100 ms per spec
+  void set_wake_time(uint32_t wake_time_ms) { this->wake_time_ = wake_time_ms; }
+  /// learn the wake time and response latency of each device and use the tightest that work
+  void set_adaptive_timing(bool adaptive_timing) { this->adaptive_timing_ = adaptive_timing; }
+  /// times a command is repeated right away when its response was corrupted
+  void set_retries(uint8_t retries) { this->retries_ = retries; }
+  /// measure the time spent in the hot paths and log it with the statistics
+  void set_performance_counters(bool performance_counters) { this->performance_counters_ = performance_counters; }
+  /// duration of the last completed transaction, from the wake-up break to the end of the response
+  uint32_t get_last_duration_us() const { return this->last_duration_us_; }
+  /// SDI12LineError flags of the last attempt of the last completed transaction
+  uint8_t get_last_line_errors() const { return this->line_errors_; }
+  /// parity errors, framing errors and overflows of the line since boot
+  SDI12LineCounters get_line_counters() const { return this->phy_->line_counters(); }
+  /// commands repeated because of line errors or a CRC mismatch since boot
+  uint32_t get_retry_count() const { return this->retry_count_; }
+  /// responses and binary packets whose CRC didn't match since boot
+  uint32_t get_crc_errors() const { return this->crc_errors_; }
+  /// commands sent without a wake-up break since boot, each saves the break and the wake time
+  uint32_t get_breaks_skipped() const { return this->breaks_skipped_; }
+  /// bus time saved by skipped breaks and learned timing since boot, in µs
+  uint64_t get_time_saved_us() const { return this->time_saved_us_; }
+  bool is_scanning() const { return this->scanning_; }
+  /// duration of the last completed scan
+  uint32_t get_scan_duration_ms() const { return this->scan_duration_ms_; }
+  /// commands sent by the last or the running scan
+  uint32_t get_scan_probes() const { return this->scan_probes_; }
+  /// time spent in the hot paths since boot, with set_performance_counters()
+  SDI12PerfCounters get_performance_counters() const;
+  bool has_performance_counters() const { return this->performance_counters_; }
+  /// count a run of the value parser of a device, started at @p start as read from sdi12_cycle_count()
+  void count_parse(uint32_t start) { this->perf_.parse.add(start); }
+  bool is_busy() const { return this->state_ != TransactionState::IDLE; }
 
  protected:
   void loop() override;
-  InternalGPIOPin *tx_pin_;
-  InternalGPIOPin *rx_pin_;
-  InternalGPIOPin *oe_pin_;
+  SDI12Device *next_device_(uint32_t now);
+  void start_transaction_(SDI12Device *device, uint32_t now);
+  void start_attempt_();
+  bool can_skip_break_(uint32_t now) const;
+  bool is_adaptive_(const SDI12Device *device) const;
+  uint32_t device_wake_ms_(const SDI12Device *device) const;
+  uint32_t device_timeout_us_(const SDI12Device *device) const;
+  /**
+   * Update the timing of the active device from the attempt that just ended. Returns true
+   * if it went unanswered with less than the configured wake-up or timeout, the command is
+   * then sent again with the configured timing.
+   */
+  bool learn_timing_();
+  void process_transaction_();
+  bool is_complete_() const;
+  const char *printable_response_() const;
+  void finish_transaction_();
+  void set_state_(TransactionState state, uint32_t now);
+  /// Wake the sensors again for a command that couldn't be sent in time
+  void restart_command_(uint32_t now);
+  void log_statistics_();
+  void poll_service_request_(uint32_t now);
+
+  std::vector<SDI12Device *> devices_;
+  SDI12Device *reserved_by_{nullptr};
+  SDI12Device *service_request_from_{nullptr};
+  /// the last characters received while waiting for a service request, a<CR><LF>
+  SDI12Buffer<3> service_request_;
+  SDI12Request active_;
+  SDI12Device *active_device_{nullptr};
+  TransactionState state_{TransactionState::IDLE};
+  uint32_t state_started_{0};
+  /// the next character of the command to send, and when the last one was complete
+  size_t tx_index_{0};
+  uint32_t tx_last_{0};
+  /// send the rest of the command in one go, loop() was too slow for it character by character
+  bool tx_in_one_go_{false};
+  /// the bus in the middle of sending a command, the others wait so it isn't held up
+  static SDI12Bus *transmitting_;
+  uint32_t last_char_{0};
+  uint32_t transaction_started_{0};
+  uint32_t first_byte_after_{0};
+  uint32_t last_duration_us_{0};
+  /// bus time spent in transactions and worst delay of a due request since the last statistics
+  uint32_t busy_us_{0};
+  uint32_t max_latency_ms_{0};
+  uint32_t statistics_started_{0};
+  uint32_t first_byte_timeout_us_{15000};
+  uint32_t char_timeout_us_{10000};
+  uint8_t retries_{2};
+  /// retries spent on the active transaction
+  uint8_t attempt_{0};
+  uint8_t line_errors_{SDI12_LINE_OK};
+  /// the PHY reported lost characters before the response started
+  bool attempt_overflowed_{false};
+  SDI12LineCounters attempt_counters_{};
+  uint32_t retry_count_{0};
+  uint32_t crc_errors_{0};
+  SDI12LineCounters reported_counters_{};
+  /// the device that answered the last command and is still awake if the line stayed active
+  char awake_address_{'\0'};
+  bool break_skipped_{false};
+  uint32_t breaks_skipped_{0};
+  /// wake time and first byte timeout of the running attempt
+  uint32_t attempt_wake_ms_{0};
+  uint32_t attempt_timeout_us_{0};
+  uint64_t time_saved_us_{0};
+  uint64_t reported_time_saved_us_{0};
+  bool adaptive_timing_{true};
+  bool performance_counters_{false};
+  /// the counters of the bus and of the devices on it, the PHY keeps its own
+  SDI12PerfCounters perf_{};
+  SDI12PerfCounters reported_perf_{};
+  SDI12Response response_;
+  /// additional time in ms the break is held for the sensors to wake, the upper bound if adaptive
+  uint32_t wake_time_{100};
+  HighFrequencyLoopRequester high_freq_;
+  InternalGPIOPin *tx_pin_{nullptr};
+  InternalGPIOPin *rx_pin_{nullptr};
+  InternalGPIOPin *oe_pin_{nullptr};
   bool initialized_ = false;
-  SDI12 SDI12_;
+  SDI12BitBangPhy bitbang_phy_;
+  SDI12Phy *phy_{&bitbang_phy_};
   std::vector<std::pair<uint8_t, std::string>> scan_results_;
   bool scan_{false};
+  bool scanning_{false};
+  uint32_t scan_started_{0};
+  uint32_t scan_duration_ms_{0};
+  uint32_t scan_probes_{0};
 
  private:
-  boolean check_device_active_(char i);
-  std::string get_device_info_(char i);
-  void init_scan_();
-  void do_scan_();
+  bool is_configured_(char address) const;
+  void probe_(std::string_view command, SDI12Callback &&callback);
+  void handle_wildcard_probe_(SDI12Status status, std::string_view response);
+  void begin_scan_();
+  void discover_();
+  void scan_next_();
+  void query_info_(char address);
+  void finish_scan_();
+  bool load_topology_();
+  void verify_topology_(size_t index);
+  void save_topology_();
+  /// issues the probes of a scan through the scheduler, at the lowest priority
+  SDI12Device *discovery_{nullptr};
   std::vector<char> addresses_to_scan_{};
+  bool topology_cache_{false};
+  uint32_t topology_key_{0};
+  ESPPreferenceObject topology_pref_;
+  /// the topology in flash, valid if topology_loaded_, even with no devices
+  SDI12Topology topology_{};
+  bool topology_loaded_{false};
 };
 
 /**
@@ -67,14 +351,98 @@ class SDI12Device {
   SDI12Device() = default;
 
   void set_sdi12_address(std::string address);
-  void set_sdi12_bus(SDI12Bus *bus) { bus_ = bus; }
+  void set_sdi12_bus(SDI12Bus *bus) {
+    bus_ = bus;
+    bus_->register_device(this);
+  }
+  /// requests of devices with a higher priority are started first when several are due
+  void set_sdi12_priority(int8_t priority) { priority_ = priority; }
+  /// request measurements with a CRC (aMC!, aCC!, aRCn!) and check it before the values are used
+  void set_sdi12_crc(bool crc) { crc_ = crc; }
+  /// delay of the first command of each poll, to spread devices with the same interval
+  void set_sdi12_phase_offset(uint32_t phase_offset) { phase_offset_ = phase_offset; }
 
   SDI12Register reg(uint8_t a_register) { return {this, a_register}; }
+  /// the wake time and response latency the bus learned for this device
+  const SDI12Timing &get_sdi12_timing() const { return timing_; }
 
  protected:
-  void parse_sdi12_values_(const std::string &response, std::vector<float*> values);
+  friend class SDI12Bus;
+
+  /// The command @p action for this device, e.g. "0M!" for "M!"
+  SDI12Command command_(std::string_view action) const {
+    SDI12Command command;
+    command.push_back(address_);
+    command.append(action);
+    return command;
+  }
+  void send_command_(std::string_view command, SDI12Callback &&callback, uint32_t delay_ms = 0,
+                     SDI12ResponseFormat format = SDI12ResponseFormat::TEXT) {
+    bus_->submit(this, command, std::move(callback), delay_ms, format);
+  }
+  /// The format of data responses, with or without a CRC
+  SDI12ResponseFormat data_format_() const {
+    return crc_ ? SDI12ResponseFormat::TEXT_CRC : SDI12ResponseFormat::TEXT;
+  }
+  /// Read the continuous measurement @p index with aRn!, or aRCn! if a CRC is requested
+  void read_continuous_(uint8_t index, SDI12Callback &&callback, uint32_t delay_ms = 0);
+  /**
+   * Read the continuous measurement @p index over and over, the next read is queued
+   * @p interval_ms after each response. With 0 it is read as often as the scheduler
+   * allows, which still serves the other devices on the bus in between. @p callback
+   * receives every response until stop_streaming_().
+   */
+  void start_streaming_(uint8_t index, SDI12Callback &&callback, uint32_t interval_ms = 0);
+  void stop_streaming_() { streaming_ = false; }
+  bool is_streaming_() const { return streaming_; }
+  void stream_next_(uint32_t delay_ms);
+  /**
+   * Start a measurement after @p delay_ms and collect its data once the sensor reports it
+   * ready, with aD0!, aD1!... until all values it announced arrived. @p callback receives
+   * the values, or the failed status of any step. An @p index of 1 to 9 starts one of the
+   * additional measurements, aM1! ... aM9!.
+   */
+  void start_measurement_(MeasurementType type, SDI12MeasurementCallback &&callback, uint32_t delay_ms = 0,
+                          uint8_t index = 0);
+  void handle_measurement_started_(MeasurementType type, SDI12Status status, std::string_view response);
+  void request_data_page_(uint8_t page, uint32_t delay_ms);
+  void handle_data_page_(uint8_t page, SDI12Status status, std::string_view response);
+  void finish_measurement_(SDI12Status status);
+  /**
+   * Start a high-volume binary measurement (aHB!) after @p delay_ms and read its packets
+   * with aDB0!, aDB1!... until all values arrived. @p callback receives each packet as
+   * it comes in, the last one flagged, or the failed status of any step.
+   */
+  void start_binary_measurement_(SDI12BinaryCallback &&callback, uint32_t delay_ms = 0);
+  void handle_binary_started_(SDI12Status status, std::string_view response);
+  void request_binary_page_(uint8_t page, uint32_t delay_ms);
+  void handle_binary_page_(uint8_t page, SDI12Status status, std::string_view response);
+  void finish_binary_measurement_(SDI12Status status);
   char address_{'0'};
   SDI12Bus *bus_{nullptr};
+  int8_t priority_{0};
+  bool crc_{false};
+  uint32_t phase_offset_{0};
+  /// times this device was passed over by the scheduler while its request was due
+  uint8_t skipped_{0};
+  SDI12Timing timing_;
+  SDI12Request request_;
+  SDI12MeasurementCallback measurement_callback_;
+  /// the values of the running measurement, filled page by page
+  float values_[SDI12_MAX_VALUES]{};
+  SDI12ValidValues values_valid_;
+  uint8_t values_expected_{0};
+  uint8_t values_received_{0};
+  SDI12BinaryCallback binary_callback_;
+  /// values announced by aHB!, and those received so far
+  uint16_t binary_count_{0};
+  uint16_t binary_received_{0};
+  SDI12Callback stream_callback_;
+  uint32_t stream_interval_{0};
+  uint8_t stream_index_{0};
+  bool streaming_{false};
+  /// a read of the stream is queued or running, it continues the stream when it completes
+  bool stream_pending_{false};
 };
 
 }  // namespace sdi12
@@ -0,0 +1,157 @@
+/**
+ * @file sdi12_binary.h
+ *
+ * @brief The packets of the high-volume binary command aHB! (SDI-12 v1.4), read with
+ * aDB0! ... aDB9!.
+ *
+ * A packet is the address, the payload size in bytes (16 bit), the data type (8 bit),
+ * the payload and the CRC-16 of all that (16 bit).  Multi-byte fields are least
+ * significant byte first, and every byte goes over the line with 8 data bits and no
+ * parity instead of the 7E1 of the text responses.  There is no <CR><LF>, the size in
+ * the header tells where the packet ends.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace esphome {
+namespace sdi12 {
+
+/// The data types of a binary packet, all values of a packet have the same type
+enum class SDI12BinaryType : uint8_t {
+  INVALID = 0,
+  INT8,
+  UINT8,
+  INT16,
+  UINT16,
+  INT32,
+  UINT32,
+  INT64,
+  UINT64,
+  FLOAT32,
+  FLOAT64,
+};
+
+/// Address, payload size and data type
+static const size_t SDI12_BINARY_HEADER_SIZE = 4;
+static const size_t SDI12_BINARY_CRC_SIZE = 2;
+/// Largest payload of a packet per spec
+static const size_t SDI12_BINARY_MAX_PAYLOAD = 1000;
+static const size_t SDI12_BINARY_MAX_PACKET =
+    SDI12_BINARY_HEADER_SIZE + SDI12_BINARY_MAX_PAYLOAD + SDI12_BINARY_CRC_SIZE;
+
+/// Bytes per value of @p type, 0 if the type is unknown
+constexpr size_t sdi12_binary_type_size(SDI12BinaryType type) {
+  switch (type) {
+    case SDI12BinaryType::INT8:
+    case SDI12BinaryType::UINT8:
+      return 1;
+    case SDI12BinaryType::INT16:
+    case SDI12BinaryType::UINT16:
+      return 2;
+    case SDI12BinaryType::INT32:
+    case SDI12BinaryType::UINT32:
+    case SDI12BinaryType::FLOAT32:
+      return 4;
+    case SDI12BinaryType::INT64:
+    case SDI12BinaryType::UINT64:
+    case SDI12BinaryType::FLOAT64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+/// The payload size in the header of a partly received packet, -1 while it is incomplete
+inline int sdi12_binary_payload_size(std::string_view received) {
+  if (received.length() < SDI12_BINARY_HEADER_SIZE)
+    return -1;
+  return static_cast<uint8_t>(received[1]) | static_cast<uint8_t>(received[2]) << 8;
+}
+
+/**
+ * @brief A view of a received binary packet, without the CRC
+ *
+ * The values are read straight from the response buffer of the bus, so a packet is only
+ * valid within the callback it is handed to.
+ */
+class SDI12BinaryPacket {
+ public:
+  /// Interpret @p packet, false if the header doesn't match the payload
+  bool parse(std::string_view packet) {
+    int size = sdi12_binary_payload_size(packet);
+    if (size < 0 || packet.length() != SDI12_BINARY_HEADER_SIZE + size)
+      return false;
+    this->address_ = packet[0];
+    this->type_ = static_cast<SDI12BinaryType>(packet[3]);
+    size_t type_size = sdi12_binary_type_size(this->type_);
+    if (type_size == 0 || size % type_size != 0)
+      return false;
+    this->payload_ = reinterpret_cast<const uint8_t *>(packet.data()) + SDI12_BINARY_HEADER_SIZE;
+    this->count_ = size / type_size;
+    return true;
+  }
+
+  char address() const { return this->address_; }
+  SDI12BinaryType type() const { return this->type_; }
+  /// number of values in the packet
+  size_t count() const { return this->count_; }
+  const uint8_t *payload() const { return this->payload_; }
+
+  /**
+   * The value at @p index as stored, @p T has to match type(). The payload isn't
+   * aligned, so it is copied out byte-wise, all ESPHome targets are little endian.
+   */
+  template<typename T> T get(size_t index) const {
+    T value;
+    std::memcpy(&value, this->payload_ + index * sizeof(T), sizeof(T));
+    return value;
+  }
+
+  /// The value at @p index of whatever type, converted
+  double value(size_t index) const {
+    switch (this->type_) {
+      case SDI12BinaryType::INT8:
+        return this->get<int8_t>(index);
+      case SDI12BinaryType::UINT8:
+        return this->get<uint8_t>(index);
+      case SDI12BinaryType::INT16:
+        return this->get<int16_t>(index);
+      case SDI12BinaryType::UINT16:
+        return this->get<uint16_t>(index);
+      case SDI12BinaryType::INT32:
+        return this->get<int32_t>(index);
+      case SDI12BinaryType::UINT32:
+        return this->get<uint32_t>(index);
+      case SDI12BinaryType::INT64:
+        return this->get<int64_t>(index);
+      case SDI12BinaryType::UINT64:
+        return this->get<uint64_t>(index);
+      case SDI12BinaryType::FLOAT32:
+        return this->get<float>(index);
+      case SDI12BinaryType::FLOAT64:
+        return this->get<double>(index);
+      default:
+        return NAN;
+    }
+  }
+
+  /// position of the first value of this packet within the measurement
+  size_t first{0};
+  /// whether this packet completes the measurement
+  bool last{false};
+
+ protected:
+  const uint8_t *payload_{nullptr};
+  size_t count_{0};
+  char address_{'\0'};
+  SDI12BinaryType type_{SDI12BinaryType::INVALID};
+};
+
+}  // namespace sdi12
+}  // namespace esphome
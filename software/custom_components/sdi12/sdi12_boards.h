@@ -23,8 +23,12 @@ sensors. This library provides a general software solution, without requiring
 
 #pragma once
 
+#if defined(USE_ARDUINO) || defined(USE_HOST)
 #ifdef USE_ARDUINO
 #include <Arduino.h>
+#else
+#include "sdi12_host.h"
+#endif
 
 namespace esphome {
 namespace sdi12 {
@@ -84,8 +88,7 @@ class SDI12Timer {
 
 
   /**
-   * @brief Read the processor micros and right shift 6 bits (ie, divide by 64) to get a
-   * 64µs tick.
+   * @brief Read the processor micros, the full 32-bit 1 µs count.
    *
    * @note  The ESP32 and ESP8266 are fast enough processors that they can take the time
    * to read the core 'micros()' function still complete the other processing needed on
@@ -97,40 +100,16 @@ class SDI12Timer {
    * @return **sdi12timer_t** The current processor micros
    */
     sdi12timer_t SDI12TimerRead(void) {
-    // Its a one microsecond clock but we want 64uS ticks so divide by 64 i.e. right shift
-    // 6
-    return ((sdi12timer_t)(micros() >> 6));
+    // Differences are taken in 32 bits, so the gap between two transitions never wraps
+    // and the bit count is rounded from the exact time.
+    return ((sdi12timer_t)micros());
     }
 
-/**
- * @brief The number of "ticks" of the timer that occur within the timing of one bit
- * at the SDI-12 baud rate of 1200 bits/second.
- *
- * 48MHz / 3 pre-prescaler = 16MHz
- * 16MHz / 1024 prescaler = 15624 'ticks'/sec = 64 µs / 'tick'
- * (1 sec/1200 bits) * (1 tick/64 µs) = 13.0208 ticks/bit
- */
-#define TICKS_PER_BIT 13
-/**
- * @brief The number of "ticks" of the timer per SDI-12 bit, shifted by 2^10.
- *
- * 1/(13.0208 ticks/bit) * 2^10 = 78.6432
- */
-#define BITS_PER_TICK_Q10 79
-/**
- * @brief A "fudge factor" to get the Rx to work well.   It mostly works to ensure that
- * uneven tick increments get rounded up.
- *
- * @see https://github.com/SlashDevin/NeoSWSerial/pull/13
- */
-#define RX_WINDOW_FUDGE 2
-
 // Raspberry Pi Pico
 //
 #elif defined(USE_RP2040)
   /**
-   * @brief Read the processor micros and right shift 6 bits (ie, divide by 64) to get a
-   * 64µs tick.
+   * @brief Read the processor micros, the full 32-bit 1 µs count.
    *
    * @note  The ESP32 and ESP8266 are fast enough processors that they can take the time
    * to read the core 'micros()' function still complete the other processing needed on
@@ -142,38 +121,22 @@ class SDI12Timer {
    * @return **sdi12timer_t** The current processor micros
    */
     sdi12timer_t SDI12TimerRead(void) {
-    // Its a one microsecond clock but we want 64uS ticks so divide by 64 i.e. right shift
-    // 6
-    return ((sdi12timer_t)(micros() >> 6));
+    // Differences are taken in 32 bits, so the gap between two transitions never wraps
+    // and the bit count is rounded from the exact time.
+    return ((sdi12timer_t)micros());
     }
 
-/**
- * @brief The number of "ticks" of the timer that occur within the timing of one bit
- * at the SDI-12 baud rate of 1200 bits/second.
- *
- * 48MHz / 3 pre-prescaler = 16MHz
- * 16MHz / 1024 prescaler = 15624 'ticks'/sec = 64 µs / 'tick'
- * (1 sec/1200 bits) * (1 tick/64 µs) = 13.0208 ticks/bit
- */
-#define TICKS_PER_BIT 13
-/**
- * @brief The number of "ticks" of the timer per SDI-12 bit, shifted by 2^10.
- *
- * 1/(13.0208 ticks/bit) * 2^10 = 78.6432
- */
-#define BITS_PER_TICK_Q10 79
-/**
- * @brief A "fudge factor" to get the Rx to work well.   It mostly works to ensure that
- * uneven tick increments get rounded up.
- *
- * @see https://github.com/SlashDevin/NeoSWSerial/pull/13
- */
-#define RX_WINDOW_FUDGE 2
+// ESPHome host platform, the virtual clock of sdi12_host.h
+//
+#elif defined(USE_HOST)
+    sdi12timer_t SDI12TimerRead(void) {
+    return ((sdi12timer_t)micros());
+    }
 
 #else
 #error "Please unsupported board for SDI-12"
 #endif
-#endif // USE_ARDUINO
+#endif // USE_ARDUINO || USE_HOST
 };
 
 }  // namespace sdi12
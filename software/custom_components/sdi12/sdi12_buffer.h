@@ -0,0 +1,82 @@
+/**
+ * @file sdi12_buffer.h
+ *
+ * @brief Fixed capacity buffers for the commands and responses of the bus, so a
+ * transaction doesn't touch the heap.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include "sdi12_binary.h"
+
+namespace esphome {
+namespace sdi12 {
+
+/**
+ * @brief Up to @p N characters, always followed by a NUL so they can be logged as is
+ *
+ * Whatever doesn't fit is refused, the callers decide whether that is an error.
+ */
+template<size_t N> class SDI12Buffer {
+ public:
+  /// Replace the contents with @p text, false if it doesn't fit
+  bool assign(std::string_view text) {
+    this->clear();
+    return this->append(text);
+  }
+  /// false if @p text doesn't fit, the buffer is unchanged then
+  bool append(std::string_view text) {
+    if (text.length() > N - this->length_)
+      return false;
+    std::memcpy(this->data_ + this->length_, text.data(), text.length());
+    this->length_ += text.length();
+    this->data_[this->length_] = '\0';
+    return true;
+  }
+  bool push_back(char c) {
+    if (this->length_ == N)
+      return false;
+    this->data_[this->length_++] = c;
+    this->data_[this->length_] = '\0';
+    return true;
+  }
+  /// Remove @p count characters from @p pos on, the rest moves up
+  void erase(size_t pos, size_t count) {
+    if (pos >= this->length_)
+      return;
+    if (count > this->length_ - pos)
+      count = this->length_ - pos;
+    std::memmove(this->data_ + pos, this->data_ + pos + count, this->length_ - pos - count + 1);
+    this->length_ -= count;
+  }
+  void clear() {
+    this->length_ = 0;
+    this->data_[0] = '\0';
+  }
+
+  const char *data() const { return this->data_; }
+  const char *c_str() const { return this->data_; }
+  size_t length() const { return this->length_; }
+  bool empty() const { return this->length_ == 0; }
+  static constexpr size_t capacity() { return N; }
+  char operator[](size_t index) const { return this->data_[index]; }
+  operator std::string_view() const { return {this->data_, this->length_}; }
+
+ protected:
+  char data_[N + 1]{};
+  size_t length_{0};
+};
+
+/// Longest command, extended commands (aX...!) included
+static const size_t SDI12_MAX_COMMAND = 32;
+/// Longest response, a binary packet; text responses stay below 100 characters
+static const size_t SDI12_MAX_RESPONSE = SDI12_BINARY_MAX_PACKET;
+
+using SDI12Command = SDI12Buffer<SDI12_MAX_COMMAND>;
+using SDI12Response = SDI12Buffer<SDI12_MAX_RESPONSE>;
+
+}  // namespace sdi12
+}  // namespace esphome
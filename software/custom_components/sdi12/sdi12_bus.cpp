@@ -52,8 +52,6 @@ namespace sdi12 {
 
 /* ================  Set static constants ===========================================*/
 
-// Pointer to active SDI12 object
-SDI12* SDI12::_activeObject = NULL;
 // Timer functions
 SDI12Timer SDI12::sdi12timer;
 
@@ -65,63 +63,48 @@ const uint16_t SDI12::lineBreak_micros = (uint16_t)12300;
 // The required mark before a command or response, >= 8.33ms
 const uint16_t SDI12::marking_micros = (uint16_t)8500;
 
-// the width of a single bit in "ticks" of the cpu clock.
-const uint8_t SDI12::txBitWidth = TICKS_PER_BIT;
-// A fudge factor to make things work
-const uint8_t SDI12::rxWindowWidth = RX_WINDOW_FUDGE;
-// The number of bits per tick, shifted by 2^10.
-const uint8_t SDI12::bitsPerTick_Q10 = BITS_PER_TICK_Q10;
-// A mask waiting for a start bit; 0b11111111
-const uint8_t SDI12::WAITING_FOR_START_BIT = 0xFF;
-
-uint16_t SDI12::prevBitTCNT;  // previous RX transition in micros
-uint8_t  SDI12::rxState;      // 0: got start bit; >0: bits rcvd
-uint8_t  SDI12::rxMask;       // bit mask for building received character
-uint8_t  SDI12::rxValue;      // character being built
-
-uint16_t SDI12::mul8x8to16(uint8_t x, uint8_t y) {
-  return x * y;
-}
-
-uint16_t SDI12::bitTimes(uint8_t dt) {
-  return mul8x8to16(dt + rxWindowWidth, bitsPerTick_Q10) >> 10;
-}
-
-
-/* ================ Buffer Setup ====================================================*/
-uint8_t          SDI12::_rxBuffer[SDI12_BUFFER_SIZE];  // The Rx buffer
-volatile uint8_t SDI12::_rxBufferTail = 0;             // index of buff tail
-volatile uint8_t SDI12::_rxBufferHead = 0;             // index of buff head
-
 
 /* ================ Reading from the SDI-12 Buffer ==================================*/
 
 // reveals the number of characters available in the buffer
 int SDI12::available() {
-  if (_bufferOverflow) return -1;
-  return (_rxBufferTail + SDI12_BUFFER_SIZE - _rxBufferHead) % SDI12_BUFFER_SIZE;
+  decodeEdges();
+  if (_rxBuffer.overflowed()) return -1;
+  return _rxBuffer.size();
 }
 
 // reveals the next character in the buffer without consuming
 int SDI12::peek() {
-  if (_rxBufferHead == _rxBufferTail) return -1;  // Empty buffer? If yes, -1
-  return _rxBuffer[_rxBufferHead];                // Otherwise, read from "head"
+  decodeEdges();
+  uint8_t nextChar;
+  if (!_rxBuffer.peek(nextChar)) return -1;  // Empty buffer? If yes, -1
+  return nextChar;                           // Otherwise, the char at "head"
 }
 
 // a public function that clears the buffer contents and resets the status of the buffer
 // overflow.
 void SDI12::clearBuffer() {
-  _rxBufferHead = _rxBufferTail = 0;
-  _bufferOverflow               = false;
+  if (_deferredDecoding) {
+    _edgeBuffer.clear();
+    _decoder.reset();
+  }
+  _rxBuffer.clear();
 }
 
 // reads in the next character from the buffer (and moves the index ahead)
 int SDI12::read() {
-  _bufferOverflow = false;                        // Reading makes room in the buffer
-  if (_rxBufferHead == _rxBufferTail) return -1;  // Empty buffer? If yes, -1
-  uint8_t nextChar = _rxBuffer[_rxBufferHead];    // Otherwise, grab char at head
-  _rxBufferHead    = (_rxBufferHead + 1) % SDI12_BUFFER_SIZE;  // increment head
-  return nextChar;                                             // return the char
+  decodeEdges();
+  _rxBuffer.clear_overflow();                // Reading makes room in the buffer
+  uint8_t nextChar;
+  if (!_rxBuffer.pop(nextChar)) return -1;  // Empty buffer? If yes, -1
+  return nextChar;                          // return the char
+}
+
+// reads as many characters as are waiting and fit into buffer
+size_t SDI12::read(uint8_t* buffer, size_t length) {
+  decodeEdges();
+  _rxBuffer.clear_overflow();  // Reading makes room in the buffer
+  return _rxBuffer.read(buffer, length);
 }
 
 // Add for RUI.
@@ -227,7 +210,7 @@ float SDI12::parseFloat(LookaheadMode lookahead, char ignore) {
 SDI12::SDI12() {
   _dataPinRX        = -1;
   _dataPinTX        = -1;
-  _bufferOverflow = false;
+  _txOE             = -1;
   // SDI-12 protocol says sensors must respond within 15 milliseconds
   // We'll bump that up to 150, just for good measure, but we don't want to
   // wait the whole stream default of 1s for a response.
@@ -244,7 +227,6 @@ SDI12::SDI12(int8_t dataPinRX , int8_t dataPinTX , int8_t txOE)
   _dataPinRX  = dataPinRX;
   _dataPinTX  = dataPinTX;
   _txOE = txOE;
-  _bufferOverflow = false;
   // SDI-12 protocol says sensors must respond within 15 milliseconds
   // We'll bump that up to 150, just for good measure, but we don't want to
   // wait the whole stream default of 1s for a response.
@@ -260,7 +242,6 @@ SDI12::SDI12(int8_t dataPinRX , int8_t dataPinTX , int8_t txOE)
 // Destructor
 SDI12::~SDI12() {
   setState(SDI12_DISABLED);
-  if (isActive()) { _activeObject = NULL; }
   // Set the timer prescalers back to original values
   // NOTE:  This does NOT reset SAMD board pre-scalers!
   sdi12timer.resetSDI12TimerPrescale();
@@ -268,8 +249,7 @@ SDI12::~SDI12() {
 
 // Begin
 void SDI12::begin() {
-  // setState(SDI12_HOLDING);
-  setActive();
+  setState(SDI12_HOLDING);
   // Set up the prescaler as needed for timers
   // This function is defined in SDI12_boards.h
   sdi12timer.configSDI12TimerPrescale();
@@ -292,7 +272,6 @@ void SDI12::begin(int8_t dataPinRX,int8_t dataPinTX,int8_t txOE)
 void SDI12::end()
 {
   setState(SDI12_DISABLED);
-  _activeObject = NULL;
   // Set the timer prescalers back to original values
   // NOTE:  This does NOT reset SAMD board pre-scalers!
   sdi12timer.resetSDI12TimerPrescale();
@@ -304,10 +283,11 @@ void SDI12::setTimeoutValue(int16_t value) {
 }
 
 // Set the data pin for the SDI-12 instance
-void SDI12::setDataPin(int8_t dataPinRX,int8_t dataPinTX)
+void SDI12::setDataPin(int8_t dataPinRX,int8_t dataPinTX,int8_t txOE)
 {
   _dataPinRX = dataPinRX;
   _dataPinTX = dataPinTX;
+  _txOE = txOE;
 }
 
 // Return the data pin for the SDI-12 instance
@@ -317,26 +297,6 @@ int8_t SDI12::getDataPin()
 }
 
 
-/* ================ Using more than one SDI-12 object ===============================*/
-// a method for setting the current object as the active object
-bool SDI12::setActive()
-{
-  if (_activeObject != this)
-  {
-    setState(SDI12_HOLDING);
-    _activeObject = this;
-    return true;
-  }
-  return false;
-}
-
-// a method for checking if this object is the active object
-bool SDI12::isActive()
-{
-  return this == _activeObject;
-}
-
-
 /* ================ Data Line States ================================================*/
 // Added MJB: parity function to replace the one specific for AVR from util/parity.h
 // http://graphics.stanford.edu/~seander/bithacks.html#ParityNaive
@@ -354,12 +314,13 @@ uint8_t SDI12::parity_even_bit(uint8_t v)
 // a helper function to switch pin interrupts on or off
 void SDI12::setPinInterrupts(bool enable)
 {
-#if defined(ARDUINO_ARCH_SAMD) || defined(USE_ESP32) || defined(USE_ESP8266)
-  // Merely need to attach the interrupt function to the pin
+#if defined(USE_ESP32) || defined(USE_ESP8266) || defined(USE_HOST)
+  // Merely need to attach the interrupt function to the pin, with this instance as its
+  // argument
   if (enable)
   {
     LIB_LOG("attachInterrupt");
-    attachInterrupt(digitalPinToInterrupt(_dataPinRX), handleInterrupt, CHANGE);
+    attachInterruptArg(digitalPinToInterrupt(_dataPinRX), handleInterrupt, this, CHANGE);
     LIB_LOG("attachInterrupt");
     // Merely need to detach the interrupt function from the pin
   }
@@ -375,8 +336,8 @@ void SDI12::setPinInterrupts(bool enable)
     mbed::InterruptIn* irq = new mbed::InterruptIn(digitalPinToPinName(_dataPinRX));
     LIB_LOG(" ");
 
-    irq->rise( mbed::callback((voidFuncPtrParam)handleInterrupt, (void*)NULL) );
-    irq->fall( mbed::callback((voidFuncPtrParam)handleInterrupt, (void*)NULL) );
+    irq->rise( mbed::callback((voidFuncPtrParam)handleInterrupt, (void*)this) );
+    irq->fall( mbed::callback((voidFuncPtrParam)handleInterrupt, (void*)this) );
 
     digitalPinToInterruptObj(_dataPinRX) = irq;
     // Give a default pullup for the pin, since calling InterruptIn with PinMode is impossible.
@@ -450,11 +411,9 @@ void SDI12::setState(SDI12_STATES state)
     {
       pinMode(_dataPinRX, INPUT);       // Pin mode = input, pull-up resistor off
 
-#if defined(USE_ESP32) || defined(USE_ESP8266)
-      interrupts();  // Re-enable universal interrupts as soon as critical timing is past
-#endif
+      _decoder.reset();             // Wait for a start bit
+      _edgeBuffer.clear();
       setPinInterrupts(true);       // Enable Rx interrupts on data pin
-      rxState = WAITING_FOR_START_BIT;
 
       pinMode(_dataPinTX, INPUT);       // Pin mode = input, pull-up resistor off
 
@@ -494,16 +453,35 @@ void SDI12::forceListen()
 /* ================ Waking Up and Talking To Sensors ================================*/
 // this function wakes up the entire sensor bus
 void SDI12::wakeSensors(int8_t extraWakeTime)
+{
+  beginBreak();
+  delayMicroseconds(lineBreak_micros);    // Required break of 12 milliseconds (12,000 µs)
+  delay(extraWakeTime);                   // allow the sensors to wake
+  beginMarking();
+  delayMicroseconds(marking_micros);      // Required marking of 8.33 milliseconds(8,333 µs)
+}
+
+// starts the break, the caller times its duration
+void SDI12::beginBreak()
 {
   setState(SDI12_TRANSMITTING);
   // Universal interrupts can be on while the break and marking happen because
   // timings for break and from the recorder are not critical.
   // Interrupts on the pin are disabled for the entire transmitting state
   digitalWrite(_dataPinTX, HIGH);          // break is HIGH
-  delayMicroseconds(lineBreak_micros);    // Required break of 12 milliseconds (12,000 µs)
-  delay(extraWakeTime);                   // allow the sensors to wake
+}
+
+// ends the break and starts the marking, the caller times its duration
+void SDI12::beginMarking()
+{
+  setState(SDI12_TRANSMITTING);          // already so after a break
   digitalWrite(_dataPinTX, LOW);         // marking is LOW
-  delayMicroseconds(marking_micros);      // Required marking of 8.33 milliseconds(8,333 µs)
+}
+
+uint32_t SDI12::getLastActivityMicros() const
+{
+  uint32_t lastRx = _lastRxMicros;
+  return static_cast<int32_t>(lastRx - _lastTxMicros) > 0 ? lastRx : _lastTxMicros;
 }
 
 // this function writes a character out on the data line
@@ -512,11 +490,18 @@ void SDI12::writeChar(uint8_t outChar)
   uint8_t currentTxBitNum = 0;  // first bit is start bit
   uint8_t bitValue        = 1;  // start bit is HIGH (inverse parity...)
 
-#if defined(USE_ESP32) || defined(USE_ESP8266)
-  noInterrupts();  // _ALL_ interrupts disabled so timing can't be shifted
-#endif
+  // Interrupts stay enabled, they would otherwise stall the receivers of the other
+  // SDI-12 lines for most of a character.  As every bit ends at a fixed offset from
+  // the start of the character, an interrupt can only delay a single transition by its
+  // own duration and doesn't shift the rest of the character.  This assumes that no
+  // interrupt, or burst of them, takes more than about 300 µs: the sensor samples in the
+  // middle of a bit, so a transition may be off by less than half a bit (416 µs) against
+  // the start bit.  The Rx interrupts of the other lines take a few µs each, and
+  // test_bit_timing checks that commands get through with 300 µs before every transition.
 
-  sdi12timer_t t0 = READTIME;  // start time
+  // start time of the character, every bit ends at its exact offset from it so the
+  // rounding of the 833.33 µs bit time doesn't add up over the character
+  sdi12timer_t t0 = READTIME;
 
   digitalWrite(
     _dataPinTX,
@@ -529,8 +514,7 @@ void SDI12::writeChar(uint8_t outChar)
   outChar |= (parityBit << 7);  // Add parity bit to the outgoing character
 
   // Calculate the position of the last bit that is a 0/HIGH (ie, HIGH, not marking)
-  // That bit will be the last time-critical bit.  All bits after that can be
-  // sent with interrupts enabled.
+  // That bit will be the last transition, the line stays marking after it.
 
   uint8_t lastHighBit =
     9;  // The position of the last bit that is a 0 (ie, HIGH, not marking)
@@ -542,8 +526,7 @@ void SDI12::writeChar(uint8_t outChar)
 
   // Hold the line for the rest of the start bit duration
 
-  while ((uint8_t)(READTIME - t0) < txBitWidth) {}
-  t0 = READTIME;  // advance start time
+  while (READTIME - t0 < sdi12_bits_to_micros(1)) {}
 
   // repeat for all data bits until the last bit different from marking
   while (currentTxBitNum++ < lastHighBit) {
@@ -558,8 +541,7 @@ void SDI12::writeChar(uint8_t outChar)
       digitalWrite(_dataPinTX, HIGH);  // set the pin state to HIGH for 0's
     }
     // Hold the line for this bit duration
-    while ((uint8_t)(READTIME - t0) < txBitWidth) {}
-    t0 = READTIME;  // start time
+    while (READTIME - t0 < sdi12_bits_to_micros(currentTxBitNum)) {}
 
     outChar = outChar >> 1;  // shift character to expose the following bit
   }
@@ -567,14 +549,8 @@ void SDI12::writeChar(uint8_t outChar)
   // Set the line low for the all remaining 1's and the stop bit
   digitalWrite(_dataPinTX, LOW);
 
-
-#if defined(USE_ESP32) || defined(USE_ESP8266)
-  interrupts();  // Re-enable universal interrupts as soon as critical timing is past
-#endif
-
   // Hold the line low until the end of the 10th bit
-  uint8_t bitTimeRemaining = txBitWidth * (10 - lastHighBit);
-  while ((uint8_t)(READTIME - t0) < bitTimeRemaining) {}
+  while (READTIME - t0 < sdi12_bits_to_micros(10)) {}
 }
 
 // The typical write functionality for a stream object
@@ -587,29 +563,14 @@ size_t SDI12::write(uint8_t byte) {
   return 1;                   // 1 character sent
 }
 
-// this function sends out the characters of the String cmd, one by one
-void SDI12::sendCommand(String& cmd, int8_t extraWakeTime) {
-  wakeSensors(extraWakeTime);  // wake up sensors
-  for (int unsigned i = 0; i < cmd.length(); i++) {
-    writeChar(cmd[i]);  // write each character
-  }
-  setState(SDI12_LISTENING);  // listen for reply
-}
-
-void SDI12::sendCommand(const char* cmd, int8_t extraWakeTime) {
-  wakeSensors(extraWakeTime);  // wake up sensors
-  for (int unsigned i = 0; i < strlen(cmd); i++) {
-    writeChar(cmd[i]);  // write each character
-  }
-  setState(SDI12_LISTENING);  // listen for reply
+// sends a character of a command after the caller already woke the sensors
+void SDI12::sendChar(uint8_t out) {
+  writeChar(out);
 }
 
-void SDI12::sendCommand(FlashString cmd, int8_t extraWakeTime) {
-  wakeSensors(extraWakeTime);  // wake up sensors
-  for (int unsigned i = 0; i < strlen_P((PGM_P)cmd); i++) {
-    // write each character
-    writeChar(static_cast<char>(pgm_read_byte((const char*)cmd + i)));
-  }
+// the command is complete, the line is released for the reply
+void SDI12::endFrame() {
+  _lastTxMicros = micros();
   setState(SDI12_LISTENING);  // listen for reply
 }
 
@@ -653,144 +614,74 @@ void SDI12::sendResponse(FlashString resp) {
 
 /* ================ Interrupt Service Routine =======================================*/
 
-// Passes off responsibility for the interrupt to the active object.
+// Passes off responsibility for the interrupt to the object the pin belongs to.
 // On espressif boards (ESP8266 and ESP32), the ISR must be stored in IRAM
 #if defined(USE_ESP32) || defined(USE_ESP8266)
-void ICACHE_RAM_ATTR SDI12::handleInterrupt() {
-  if (_activeObject) _activeObject->receiveISR();
+void ICACHE_RAM_ATTR SDI12::handleInterrupt(void* instance) {
+  static_cast<SDI12*>(instance)->receiveISR();
 }
 #else
-void SDI12::handleInterrupt() {
-  if (_activeObject) _activeObject->receiveISR();
+void SDI12::handleInterrupt(void* instance) {
+  static_cast<SDI12*>(instance)->receiveISR();
 }
 #endif
 
-// Creates a blank slate of bits for an incoming character
-void SDI12::startChar() {
-  rxState = 0x00;  // 0b00000000, got a start bit
-  rxMask  = 0x01;  // 0b00000001, bit mask, lsb first
-  rxValue = 0x00;  // 0b00000000, RX character to be, a blank slate
-}  // startChar
-
 // The actual interrupt service routine
+#if defined(USE_ESP32) || defined(USE_ESP8266)
+void ICACHE_RAM_ATTR SDI12::receiveISR() {
+#else
 void SDI12::receiveISR() {
+#endif
+  uint32_t perfStart = _perfCounters ? sdi12_cycle_count() : 0;
+
   // time of this data transition (plus ISR latency)
   sdi12timer_t thisBitTCNT = READTIME;
 
   uint8_t pinLevel = digitalRead(_dataPinRX);  // current RX data level
 
-  // Check if we're ready for a start bit, and if this could possibly be it.
-  if (rxState == WAITING_FOR_START_BIT) {
-    // If we are waiting for a start bit and the pin is low it's not a start bit, exit
-    // Inverse logic start bit = HIGH
-    //if (pinLevel == LOW) { return; }
-    if (pinLevel == HIGH) { return; }
-    // If the pin is HIGH, this should be a start bit.
-    // Thus startChar(), which sets the rxState to 0, create an empty character, and a
-    // new mask with a 1 in the lowest place
-    startChar();
+  if (_deferredDecoding) {
+    // Only record the transition, decodeEdges() takes care of the rest
+    if (!_edgeBuffer.push({thisBitTCNT, pinLevel})) { _edgeOverflows = _edgeOverflows + 1; }
   } else {
-    // If we're not waiting for a start bit, it's because we're in the middle of an
-    // incomplete character and therefore this change in the pin state must be from a
-    // data, parity, or stop bit.
-
-    // Check how many bit times have passed since the last change
-    uint16_t rxBits = bitTimes((uint8_t)(thisBitTCNT - prevBitTCNT));
-    // Calculate how many *data+parity* bits should be left in the current character
-    //      - Each character has a total of 10 bits, 1 start bit, 7 data bits, 1 parity
-    // bit, and 1 stop bit
-    //      - The #rxState holds record of how many of the data + parity bits we've
-    // gotten (up to 8)
-    //      - We have to treat the parity bit as a data bit because we don't know its
-    // state
-    //      - Since we're mid character, we know the start bit is past which knocks us
-    // down to 9
-    //      - There will always be one left over for the stop bit, which will be LOW/1
-    uint8_t bitsLeft = 9 - rxState;
-    // If the number of bits passed since the last transition is more than then number
-    // of bits left on the character we were working on, a new character must have
-    // started.
-    // This will happen if the parity bit is 1 or the last bit(s) of the character and
-    // the parity bit are all 1's.
-    bool nextCharStarted = (rxBits > bitsLeft);
-
-    // Check how many data+parity bits have been sent in this frame.  This will be
-    // different from the rxBits if a new character has started because of the start
-    // and stop bits.
-    //      - If the total number of bits in this frame is more than the number of
-    // data+parity bits remaining in the character, then the number of data+parity bits
-    // is equal to the number of bits remaining for the character and partiy.
-    //      - If the total number of bits in this frame is less than the number of data
-    // bits left for the character and parity, then the number of data+parity bits
-    // received in this frame is equal to the total number of bits received in this
-    // frame.
-    // translation:
-    //    if nextCharStarted then bitsThisFrame = bitsLeft
-    //                       else bitsThisFrame = rxBits
-    uint8_t bitsThisFrame = nextCharStarted ? bitsLeft : rxBits;
-    // Tick up the rxState by the number of data+parity bits received in the frame
-    rxState += bitsThisFrame;
-
-    // Set all the bits received between the last change and this change
-    //if (pinLevel == HIGH) {
-    if (pinLevel == LOW) {
-      // If the current state is HIGH (and it just became so), then all bits between
-      // the last change and now must have been LOW.
-      // back fill previous bits with 1's (inverse logic - LOW = 1)
-      while (bitsThisFrame-- > 0) {
-        // for each of the bits that happened in this frame
-
-        rxValue |= rxMask;     // Add a 1 to the LSB/right-most place of our character
-                               // value from the mask
-        rxMask = rxMask << 1;  // Shift the 1 in the mask up by one position
-      }
-      // And shift the 1 in the mask up by one more position for the current bit.
-      // It's HIGH/0 now, so we don't use `|=` with the mask for this last one.
-      rxMask = rxMask << 1;
-    } else {
-      // If the current state is LOW (and it just became so), then this bit is LOW
-      // but all bits between the last change and now must have been HIGH
-
-      // pinLevel==LOW
-      // previous bits were 0's so only this bit is a 1 (inverse logic - LOW = 1)
-      rxMask = rxMask << (bitsThisFrame -
-                          1);  // Shift the 1 in the mask up by the number of bits past
-      rxValue |= rxMask;  //  And add that shifted one to the character being created
+    uint8_t c;
+    if (_decoder.feed(thisBitTCNT, pinLevel, c)) {
+      charToBuffer(c);  // Put the finished character into the buffer
     }
+  }
 
-   // If this was the 8th or more bit then the character and parity are complete.
-    if (rxState > 7) {
-      rxValue &= 0x7F;        // Throw away the parity bit (and with 0b01111111)
-      charToBuffer(rxValue);  // Put the finished character into the buffer
-
-
-      // if this is LOW, or we haven't exceeded the number of bits in a
-      // character (but have gotten all the data bits) then this should be a
-      // stop bit and we can start looking for a new start bit.
-      //if ((pinLevel == LOW) || !nextCharStarted) {
-      if ((pinLevel == HIGH) || !nextCharStarted) {
-        rxState = WAITING_FOR_START_BIT;  // DISABLE STOP BIT TIMER
-      } else {
-        // If we just switched to HIGH, or we've exceeded the total number of
-        // bits in a character, then the character must have ended with 1's/LOW,
-        // and this new 0/HIGH is actually the start bit of the next character.
-        startChar();
-      }
-    }
+  if (_perfCounters) { _isrPerf.add(perfStart); }
+}
+
+// Decodes the transitions the ISR recorded, outside of the interrupt context
+void SDI12::decodeEdges() {
+  uint8_t c;
+  if (!_deferredDecoding) {
+    // The ISR completes each character on a transition, but one whose last bits and
+    // parity are 1's (any byte >= 0xC0 of a binary packet) ends without one.  Complete
+    // it here once its time has passed, with the ISR held off as it owns the decoder.
+    noInterrupts();
+    if (_decoder.flush(READTIME, c)) { charToBuffer(c); }
+    interrupts();
+    return;
   }
-  prevBitTCNT = thisBitTCNT;  // finally remember time stamp of this change!
+
+  SDI12Edge edge;
+  while (_edgeBuffer.pop(edge)) {
+    uint32_t perfStart = _perfCounters ? sdi12_cycle_count() : 0;
+    if (_decoder.feed(edge.time, edge.level, c)) { charToBuffer(c); }
+    if (_perfCounters) { _decodePerf.add(perfStart); }
+  }
+  // A last character ending in 1's has no closing transition.  Only conclude that from
+  // the current time while no newer transition is waiting.
+  sdi12timer_t now = READTIME;
+  if (_edgeBuffer.size() == 0 && _decoder.flush(now, c)) { charToBuffer(c); }
 }
 
 // Put a new character in the buffer
 void SDI12::charToBuffer(uint8_t c) {
-  // Check for a buffer overflow. If not, proceed.
-  if ((_rxBufferTail + 1) % SDI12_BUFFER_SIZE == _rxBufferHead) {
-    _bufferOverflow = true;
-  } else {
-    // Save the character, advance buffer tail.
-    _rxBuffer[_rxBufferTail] = c;
-    _rxBufferTail            = (_rxBufferTail + 1) % SDI12_BUFFER_SIZE;
-  }
+  // Save the character and advance the buffer tail, a full buffer flags the overflow
+  if (!_rxBuffer.push(c)) { _rxOverflows = _rxOverflows + 1; }
+  _lastRxMicros = micros();
 }
 
 }  // namespace sdi12
@@ -112,7 +112,7 @@
  * - Buffer Setup
  * - Reading from the SDI-12 Buffer
  * - Constructor, Destructor, Begins, and Setters
- * - Using more than one SDI-12 object, isActive() and setActive()
+ * - Using more than one SDI-12 object
  * - Setting Proper Data Line States
  * - Waking up and Talking to the Sensors
  * - Interrupt Service Routine (getting the data into the buffer)
@@ -122,9 +122,16 @@
 
 //  Import Required Libraries
 #include <inttypes.h>      // integer types library
+#ifdef USE_HOST
+#include "sdi12_host.h"    // Virtual clock and pins instead of the Arduino core
+#else
 #include <Arduino.h>       // Arduino core library
 #include <Stream.h>        // Arduino Stream library
+#endif
 #include "sdi12_boards.h"  // Include timer information
+#include "sdi12_ring_buffer.h"  // Lock-free Rx buffer
+#include "sdi12_decoder.h"      // Character reconstruction from Rx edges
+#include "sdi12_perf.h"         // Cycle counters of the hot paths
 
 #if defined(USE_RP2040)
   #include "pinDefinitions.h"
@@ -151,7 +158,7 @@ typedef const __FlashStringHelper* FlashString;
 
 #ifndef SDI12_BUFFER_SIZE
 /**
- * @brief The buffer size for incoming SDI-12 data.
+ * @brief The buffer size for incoming SDI-12 data, must be a power of two.
  *
  * All responses should be less than 81 characters:
  * - address is a single (1) character
@@ -159,11 +166,24 @@ typedef const __FlashStringHelper* FlashString;
  * - CRC is 3 characters
  * - CR is a single character
  * - LF is a single character
+ *
+ * The next power of two keeps a whole response.
+ */
+#define SDI12_BUFFER_SIZE 128
+#endif
+
+#ifndef SDI12_EDGE_BUFFER_SIZE
+/**
+ * @brief The number of Rx transitions that can wait for deferred decoding, must be a
+ * power of two.
+ *
+ * A character has at most 10 transitions, so the default covers at least 12
+ * characters, or 100 ms without decoding.
  */
-#define SDI12_BUFFER_SIZE 81
+#define SDI12_EDGE_BUFFER_SIZE 128
 #endif
 
-#if defined(USE_ESP32) || defined(USE_ESP8266)
+#if defined(USE_ESP32) || defined(USE_ESP8266) || defined(USE_HOST)
 
 /**
  * @brief This enumeration provides the lookahead options for parseInt(), parseFloat().
@@ -199,7 +219,7 @@ enum LookaheadMode {
 
 #define READTIME sdi12timer.SDI12TimerRead()
 
-#endif  // defined(USE_ESP32) || defined(USE_ESP8266)
+#endif  // defined(USE_ESP32) || defined(USE_ESP8266) || defined(USE_HOST)
 
 /**
  * @brief The main class for SDI 12 instances
@@ -213,10 +233,6 @@ class SDI12 : public Stream {
    */
   /**@{*/
  private:
-  /**
-   * @brief static pointer to active SDI12 instance
-   */
-  static SDI12* _activeObject;
   /**
    * @brief The SDI12Timer instance to use for checking bit reception times.
    */
@@ -227,6 +243,8 @@ class SDI12 : public Stream {
    * 1200 baud = 1200 bits/second ~ 833.333 µs/bit
    */
   static const uint16_t bitWidth_micros;
+
+ public:
   /**
    * @brief The required "break" before sending commands, >= 12ms
    *
@@ -236,75 +254,6 @@ class SDI12 : public Stream {
    * @brief The required mark before a command or response, >= 8.33ms
    */
   static const uint16_t marking_micros;
-
-  /**
-   * @brief the width of a single bit in "ticks" of the cpu clock.
-   */
-  static const uint8_t txBitWidth;
-  /**
-   * @brief A fudge factor to make things work
-   */
-  static const uint8_t rxWindowWidth;
-  /**
-   * @brief The number of bits per tick, shifted by 2^10.
-   */
-  static const uint8_t bitsPerTick_Q10;
-  /**
-   * @brief A mask for the #rxState while waiting for a start bit; 0b11111111
-   */
-  static const uint8_t WAITING_FOR_START_BIT;
-
-  /**
-   * @brief Stores the time of the previous RX transition in micros
-   */
-  static uint16_t prevBitTCNT;
-  /**
-   * @brief Tracks how many bits are accounted for on an incoming character.
-   *
-   * - if 0: indicates that we got a start bit
-   * - if >0: indicates the number of bits received
-   */
-  static uint8_t rxState;
-  /**
-   * @brief a bit mask for building a received character
-   *
-   * The mask has a single bit set, in the place of the active bit based on the
-   * #rxState.
-   */
-  static uint8_t rxMask;
-  /**
-   * @brief the value of the character being built
-   */
-  static uint8_t rxValue;
-
-  /**
-   * @brief static method for getting a 16-bit value from the multiplication of 2 8-bit
-   * values
-   *
-   * @param x The first 8 bit integer
-   * @param y The second 8 bit integer
-   * @return @m_span{m-type} uint16_t @m_endspan The result of the multiplication, as a
-   * 16 bit integer.
-   */
-  static uint16_t mul8x8to16(uint8_t x, uint8_t y);
-
-  /**
-   * @brief static method for calculating the number of bit-times that have elapsed
-   * given an 8-bit counter/timer timestamp.
-   *
-   * @param dt The current value of the 8-bit timer
-   * @return @m_span{m-type} uint16_t @m_endspan The number of bit times that have
-   * passed at 1200 baud.
-   *
-   * Adds a rxWindowWidth fudge factor to the time difference to get the number of
-   * ticks, and then multiplies the fudged ticks by the number of bits per tick.  Uses
-   * the number of bits per tick shifted up by 2^10 and then shifts the result down by
-   * the same amount to compensate for the fact that the number of bits per tick is a
-   * decimal the timestamp is only an 8-bit integer.
-   *
-   * @see https://github.com/SlashDevin/NeoSWSerial/pull/13#issuecomment-315463522
-   */
-  static uint16_t bitTimes(uint8_t dt);
   /**@}*/
 
 
@@ -315,12 +264,12 @@ class SDI12 : public Stream {
    * @brief Creating a circular buffer for incoming data.
    *
    * The buffer is used to store characters from the SDI-12 data line.  Characters are
-   * read into the buffer when an interrupt is received on the data line. The buffer
-   * uses a circular implementation with pointers to both the head and the tail. All
-   * SDI-12 instances share the same buffer.
+   * read into the buffer when an interrupt is received on the data line. Each SDI-12
+   * instance has its own buffer, a lock-free single-producer/single-consumer ring (see
+   * SDI12RingBuffer) filled by the ISR and drained by the reading functions.
    *
    * The default buffer size is the maximum length of a response to a normal SDI-12
-   * command, which is 81 characters:
+   * command, which is 81 characters, rounded up to the next power of two:
    * - address is a single (1) character
    * - values has a maximum value of 75 characters
    * - CRC is 3 characters
@@ -333,26 +282,53 @@ class SDI12 : public Stream {
   /**@{*/
  private:
   /**
-   * @brief A single incoming character buffer for ALL SDI-12 objects (Rx buffer)
+   * @brief The incoming character buffer of this SDI-12 object (Rx buffer)
    *
-   * Increasing the buffer size will use more RAM. If you exceed 256 characters, be sure
-   * to change the data type of the index to support the larger range of addresses.  To
-   * adjust the size of the buffer, change the value of `SDI12_BUFFER_SIZE` in the
-   * header file.
+   * Increasing the buffer size will use more RAM.  To adjust the size of the buffer,
+   * change the value of `SDI12_BUFFER_SIZE` in the header file, it has to stay a power
+   * of two.  The buffer also tracks whether a character was dropped because it was full.
+   */
+  SDI12RingBuffer<uint8_t, SDI12_BUFFER_SIZE> _rxBuffer;
+  /**
+   * @brief Rx transitions recorded by the ISR, waiting to be decoded (deferred decoding)
+   */
+  SDI12RingBuffer<SDI12Edge, SDI12_EDGE_BUFFER_SIZE> _edgeBuffer;
+  /**
+   * @brief The reception state, turning Rx transitions into characters
    */
-  static uint8_t _rxBuffer[SDI12_BUFFER_SIZE];
+  SDI12EdgeDecoder _decoder;
   /**
-   * @brief Index of buffer head. (unsigned 8-bit integer, can map from 0-255)
+   * @brief Decode characters outside of the ISR
    */
-  static volatile uint8_t _rxBufferTail;
+  bool _deferredDecoding = false;
   /**
-   * @brief Index of buffer tail. (unsigned 8-bit integer, can map from 0-255)
+   * @brief micros() when the last character was put into the Rx buffer
    */
-  static volatile uint8_t _rxBufferHead;
+  volatile uint32_t _lastRxMicros = 0;
   /**
-   * @brief The buffer overflow status
+   * @brief micros() when the last character of a command was sent
    */
-  bool _bufferOverflow;
+  uint32_t _lastTxMicros = 0;
+  /**
+   * @brief Characters lost to a full Rx buffer, only written by charToBuffer()
+   */
+  volatile uint32_t _rxOverflows = 0;
+  /**
+   * @brief Transitions lost to a full edge buffer, only written by the ISR
+   */
+  volatile uint32_t _edgeOverflows = 0;
+  /**
+   * @brief Measure the time spent in the ISR and in decoding
+   */
+  bool _perfCounters = false;
+  /**
+   * @brief Cycles spent in the ISR per transition, only written by the ISR
+   */
+  SDI12PerfCounter _isrPerf;
+  /**
+   * @brief Cycles spent decoding a recorded transition, only written by decodeEdges()
+   */
+  SDI12PerfCounter _decodePerf;
   /**@}*/
 
 
@@ -385,38 +361,8 @@ class SDI12 : public Stream {
    * available() is a public function that returns the number of characters available in
    * the Rx buffer.
    *
-   * To understand how:
-   * `_rxBufferTail + SDI12_BUFFER_SIZE - _rxBufferHead) % SDI12_BUFFER_SIZE;`
-   * accomplishes this task, we will use a few examples.
-   *
-   * To start take the buffer below that has `SDI12_BUFFER_SIZE = 10`. The message
-   * "abc" has been wrapped around (circular buffer).
-   *
-   * @code{.cpp}
-   *     _rxBufferTail = 1 // points to the '-' after c
-   *     _rxBufferHead = 8 // points to 'a'
-   * @endcode
-   *
-   * [ c ] [ - ] [ - ] [ - ] [ - ] [ - ] [ - ] [ - ]  [ a ] [ b ]
-   *
-   * The number of available characters is (1 + 10 - 8) % 10 = 3
-   *
-   * The '%' or modulo operator finds the remainder of division of one number by
-   * another. In integer arithmetic 3 / 10 = 0, but has a remainder of 3.  We can only
-   * get the remainder by using the the modulo '%'. 3 % 10 = 3.  This next case
-   * demonstrates more clearly why the modulo is used.
-   *
-   * @code{.cpp}
-   *     _rxBufferTail = 4 // points to the '-' after c
-   *     _rxBufferHead = 1 // points to 'a'
-   * @endcode
-   *
-   * [ a ] [ b ] [ c ] [ - ] [ - ] [ - ] [ - ] [ - ]  [ - ] [ - ]
-   *
-   * The number of available characters is (4 + 10 - 1) % 10 = 3
-   *
-   * If we did not use the modulo we would get either ( 4 + 10 - 1 ) = 13 characters or
-   * ( 4 + 10 - 1 ) / 10 = 1 character. Obviously neither is correct.
+   * The head and tail of the buffer are free running counters, so their difference is
+   * the number of waiting characters even after they wrapped around the buffer.
    *
    * If there has been a buffer overflow, available() will return -1.
    */
@@ -450,6 +396,74 @@ class SDI12 : public Stream {
    * the index to head intact, you should use peek();
    */
   int read() override;
+  /**
+   * @brief Move up to @p length bytes from the Rx buffer into @p buffer without blocking
+   *
+   * @param buffer where to store the characters
+   * @param length the maximum number of characters to read
+   * @return @m_span{m-type} size_t @m_endspan The number of characters read
+   *
+   * Like read(), this clears the buffer overflow status.
+   */
+  size_t read(uint8_t* buffer, size_t length);
+  /**
+   * @brief Decode the Rx transitions outside of the interrupt context
+   *
+   * @param deferred True to only record transitions in the ISR
+   *
+   * By default the ISR reconstructs the characters as the transitions arrive.  With
+   * deferred decoding, the ISR only stores the time and level of each transition and
+   * the characters are decoded when the buffer is read.  This keeps the time spent in
+   * the ISR short and constant, at the cost of a buffer for the transitions.
+   */
+  void setDeferredDecoding(bool deferred) { _deferredDecoding = deferred; }
+  /**
+   * @brief Count the cycles spent in the ISR and in decodeEdges(), per transition
+   *
+   * @param enable True to measure, it costs two reads of the cycle counter per transition
+   */
+  void setPerformanceCounters(bool enable) { _perfCounters = enable; }
+  /**
+   * @brief The cycles spent in the ISR since construction
+   */
+  SDI12PerfCounter getInterruptCounter() const { return _isrPerf; }
+  /**
+   * @brief The cycles spent decoding recorded transitions since construction
+   */
+  SDI12PerfCounter getDecodeCounter() const { return _decodePerf; }
+  /**
+   * @brief Receive bytes with 8 data bits and no parity
+   *
+   * @param binary True for the packets of the high-volume binary command, false for the
+   * usual 7 data bits with even parity
+   *
+   * Switch it while the line is quiet, a character being received may be decoded with
+   * either framing.
+   */
+  void setBinaryMode(bool binary) { _decoder.set_binary(binary); }
+  /**
+   * @brief The time a character was last put into the Rx buffer
+   *
+   * @return @m_span{m-type} uint32_t @m_endspan micros() when the most recent character
+   * was completed
+   */
+  uint32_t getLastRxMicros() const { return _lastRxMicros; }
+  /**
+   * @brief The time the line was last active, by a command or a received character
+   *
+   * @return @m_span{m-type} uint32_t @m_endspan micros() at the end of the most recent
+   * character in either direction
+   */
+  uint32_t getLastActivityMicros() const;
+  /**
+   * @brief Cumulative counts of parity errors, framing errors and lost characters or
+   * transitions on this line
+   *
+   * @return @m_span{m-type} SDI12LineCounters @m_endspan The counts since construction
+   */
+  SDI12LineCounters getLineCounters() const {
+    return {_decoder.parity_errors(), _decoder.framing_errors(), _rxOverflows + _edgeOverflows};
+  }
   /**
    * @brief Wait for sending to finish - because no TX buffering, does nothing
    */
@@ -536,7 +550,7 @@ class SDI12 : public Stream {
    * SDI12::setDataPin(dataPin) or SDI12::begin(dataPin). This empty constructor is
    * provided for easier integration with other Arduino libraries.
    *
-   * When the constructor is called it resets the buffer overflow status to FALSE.
+   * The buffer overflow status of a new instance is FALSE.
    */
   SDI12();
   /**
@@ -544,8 +558,8 @@ class SDI12 : public Stream {
    *
    * @param dataPin The data pin's digital pin number
    *
-   * When the constructor is called it resets the buffer overflow status to FALSE and
-   * assigns the pin number "dataPin" to the private variable "_dataPin".
+   * When the constructor is called it assigns the pin number "dataPin" to the private
+   * variable "_dataPin".
    */
   explicit SDI12(int8_t dataPinRX,int8_t dataPinTX,int8_t txOE);
 
@@ -623,11 +637,13 @@ class SDI12 : public Stream {
    */
   int8_t getDataPin();
   /**
-   * @brief Set the data pin for the current SDI-12 instance
+   * @brief Set the data pins for the current SDI-12 instance
    *
-   * @param dataPin  The data pin's digital pin number
+   * @param dataPinRX  The receive pin's digital pin number
+   * @param dataPinTX  The transmit pin's digital pin number
+   * @param txOE  The transmit output enable pin's digital pin number
    */
-  void setDataPin(int8_t dataPinRX , int8_t dataPinTX);
+  void setDataPin(int8_t dataPinRX , int8_t dataPinTX, int8_t txOE);
   /**@}*/
 
 
@@ -635,61 +651,17 @@ class SDI12 : public Stream {
    * @anchor multiple_objects
    * @name Using more than one SDI-12 Object
    *
-   * @brief Functions needed for multiple instances of the SDI12 class.
-   *
-   * This library is allows for multiple instances of itself running on the same or
-   * different pins.  SDI-12 can support up to 62 sensors on a single pin/bus, so it is
-   * not necessary to use an instance for each sensor.
-   *
-   * Because we are using pin change interrupts there can only be one active object at a
-   * time (since this is the only reliable way to determine which pin the interrupt
-   * occurred on).  The active object is the only object that will respond properly to
-   * interrupts.  However promoting another instance to Active status does not
-   * automatically remove the interrupts on the other pin. For proper behavior it is
-   * recommended to use this pattern:
+   * @brief Several instances on different pins work at the same time.
    *
-   * @code{.cpp}
-   *     mySDI12.forceHold();
-   *     myOtherSDI12.setActive();
-   * @endcode
+   * This library allows for multiple instances of itself running on different pins.
+   * SDI-12 can support up to 62 sensors on a single pin/bus, so it is not necessary to
+   * use an instance for each sensor, but separate lines can be polled in parallel.
    *
-   * @note
-   * - Promoting an object into the Active state will set it as `SDI12_HOLDING`.
-   * - Calling mySDI12.begin() will assert mySDI12 as the new active object, until
-   * another instance calls myOtherSDI12.begin() or myOtherSDI12.setActive().
-   * - Calling mySDI12.end() does NOT hand-off active status to another SDI-12 instance.
-   * - You can check on the active object by calling mySDI12.isActive(), which will
-   * return a boolean value TRUE if active or FALSE if inactive.
+   * Each instance attaches its own pin change interrupt with a pointer to itself as
+   * the argument, and keeps its reception state, edge and character buffers to itself.
+   * So all instances that are listening receive at the same time, there is no active
+   * object to hand over.
    */
-  /**@{*/
- public:
-  /**
-   * @brief Set this instance as the active SDI-12 instance
-   *
-   * @return @m_span{m-type} bool @m_endspan True indicates that the current SDI-12
-   * instance was not formerly the active one and now is.  False indicates that the
-   * current SDI-12 instance *is already the active one* and the state was not changed.
-   *
-   * A method for setting the current object as the active object; returns TRUE if
-   * the object was not formerly the active object and now is.
-   * - Promoting an inactive to the active instance will start it in the SDI12_HOLDING
-   * state and return TRUE.
-   * - Otherwise, if the object is currently the active instance, it will remain
-   * unchanged and return FALSE.
-   */
-  bool setActive();
-
-  /**
-   * @brief Check if this instance is active
-   *
-   * @return @m_span{m-type} bool @m_endspan True indicates that the curren SDI-12
-   * instace is the active one.
-   *
-   * isActive() is a method for checking if the object is the active object.  Returns
-   * true if the object is currently the active object, false otherwise.
-   */
-  bool isActive();
-  /**@}*/
 
 
   /**
@@ -765,6 +737,7 @@ class SDI12 : public Stream {
     SDI12_LISTENING
   } SDI12_STATES;
 
+ public:
   /**
    * @brief Calculate the parity value for a character using even parity.
    *
@@ -776,10 +749,11 @@ class SDI12 : public Stream {
    * interrupts and parity for the AVR processors where they exist.
    *
    * This function is defined in the Arduino core for AVR processors, but must be
-   * defined here for SAMD and ESP cores.
+   * defined here for SAMD and ESP cores.  Public for the host benchmark.
    */
   static uint8_t parity_even_bit(uint8_t v);
 
+ private:
   /**
    * @brief Set the pin interrupts to be on (enabled) or off (disabled)
    *
@@ -893,28 +867,41 @@ class SDI12 : public Stream {
    * Sets the state to transmitting, writes a character, and then sets the state back to
    * listening.  This function must be implemented as part of the Arduino Stream
    * instance, but is *NOT* intenteded to be used for SDI-12 objects.  Instead, use the
-   * SDI12::sendCommand() or SDI12::sendResponse() functions.
+   * SDI12::sendChar() or SDI12::sendResponse() functions.
    */
   virtual size_t write(uint8_t byte);
 
   /**
-   * @brief Send a command out on the data line, acting as a datalogger (master)
+   * @brief Start the break that wakes the sensors, without waiting for it to elapse
    *
-   * @param cmd the command to send
+   * Sets the SDI-12 state to transmitting and pulls the data line to spacing.  The
+   * caller is responsible for holding the break for at least #lineBreak_micros before
+   * calling SDI12::beginMarking().
+   */
+  void beginBreak();
+  /**
+   * @brief End the break and start the marking that precedes a command
+   *
+   * Also takes the line without a break first, for a command within 87 ms of the last
+   * activity.  The caller is responsible for
+   * holding the marking for at least #marking_micros before calling
+   * SDI12::sendChar().
+   */
+  void beginMarking();
+  /**
+   * @brief Send a character of a command without waking the sensors first
    *
-   * A publicly accessible function that sends a break to wake sensors and sends out a
-   * command byte by byte on the data line.
+   * @param out the character to send
    *
-   * @param extraWakeTime The amount of additional time in milliseconds that the sensor
-   * takes to wake before being ready to receive a command.  Default is 0ms - meaning
-   * the sensor is ready for a command by the end of the 12ms break.  Per protocol, the
-   * wake time must be less than 100 ms.
+   * Used together with SDI12::beginBreak(), SDI12::beginMarking() and SDI12::endFrame()
+   * by callers that sequence the command themselves.  Blocks for the one character only, the caller has to send the
+   * next one within 1.66 ms.
    */
-  void sendCommand(String& cmd, int8_t extraWakeTime = SDI12_WAKE_DELAY);
-  /// @copydoc SDI12::sendCommand(String&, int8_t)
-  void sendCommand(const char* cmd, int8_t extraWakeTime = SDI12_WAKE_DELAY);
-  /// @copydoc SDI12::sendCommand(String&, int8_t)
-  void sendCommand(FlashString cmd, int8_t extraWakeTime = SDI12_WAKE_DELAY);
+  void sendChar(uint8_t out);
+  /**
+   * @brief End a command sent with SDI12::sendChar() and switch to listening for the reply
+   */
+  void endFrame();
 
   /**
    * @brief Send a response out on the data line (for slave use)
@@ -945,9 +932,10 @@ class SDI12 : public Stream {
   /**@{*/
  private:
   /**
-   * @brief Creates a blank slate for a new incoming character
+   * @brief Decode the transitions recorded by the ISR into the Rx buffer (deferred
+   * decoding)
    */
-  void startChar();
+  void decodeEdges();
   /**
    * @brief The interrupt service routine (ISR) - the function responding to changes in
    * rx line state.
@@ -961,6 +949,9 @@ class SDI12 : public Stream {
    * in an ISR that lasts for 8.33ms for each character. [10 bits @ 1200 bits/s] For a
    * person, that 8.33ms is trivial, but for even a "slow" 8MHz processor, that's over
    * 60,000 ticks sitting idle per character.
+   *
+   * With deferred decoding, the ISR only records the time and level of the transition
+   * and the character is reconstructed later by decodeEdges().
    */
   void receiveISR();
   /**
@@ -973,11 +964,13 @@ class SDI12 : public Stream {
  public:
   /**
    * @brief Intermediary used by the ISR - passes off responsibility for the interrupt
-   * to the active object.
+   * to the instance the pin belongs to.
+   *
+   * @param instance the SDI12 object that attached the interrupt
    *
    * On espressif boards (ESP8266 and ESP32), the ISR must be stored in IRAM
    */
-  static void handleInterrupt();
+  static void handleInterrupt(void* instance);
 
   /**@}*/
 };
@@ -0,0 +1,99 @@
+/**
+ * @file sdi12_crc.h
+ *
+ * @brief The CRC of SDI-12 responses to aMC!, aCC! and aRCn!, and of binary packets,
+ * checked before the values are used.
+ *
+ * The CRC-16 (polynomial 0xA001, reflected, initial value 0) covers the response from
+ * the address to the last value.  It is appended as three ASCII characters right before
+ * the <CR><LF>, each holding six bits of the CRC with 0x40 added, or as two bytes after
+ * the payload of a binary packet.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace sdi12 {
+
+/**
+ * @brief The CRC after a whole byte, for each value of the byte XORed into the CRC
+ *
+ * Generated by the compiler, so the table costs 512 bytes of flash and nothing at runtime.
+ */
+struct SDI12CrcTable {
+  uint16_t entries[256];
+
+  constexpr SDI12CrcTable() : entries() {
+    for (uint16_t index = 0; index < 256; index++) {
+      uint16_t crc = index;
+      for (uint8_t bit = 0; bit < 8; bit++)
+        crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+      this->entries[index] = crc;
+    }
+  }
+};
+
+inline constexpr SDI12CrcTable SDI12_CRC_TABLE{};
+
+/// The CRC-16 of @p length characters at @p data, a byte per table lookup
+constexpr uint16_t sdi12_crc16(const char *data, size_t length) {
+  uint16_t crc = 0;
+  for (size_t i = 0; i < length; i++)
+    crc = (crc >> 8) ^ SDI12_CRC_TABLE.entries[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF];
+  return crc;
+}
+
+// The example of the SDI-12 specification, 0D0!0+3.14OqZ<CR><LF>
+static_assert(sdi12_crc16("0+3.14", 6) == 0xFC5A, "SDI-12 CRC-16 doesn't match the specification");
+static_assert(SDI12_CRC_TABLE.entries[1] == 0xC0C1 && SDI12_CRC_TABLE.entries[255] == 0x4040,
+              "SDI-12 CRC-16 table is broken");
+
+/// The three characters of @p crc, as sent by the sensor
+constexpr char sdi12_crc_char(uint16_t crc, uint8_t index) {
+  return static_cast<char>(0x40 | ((crc >> (12 - 6 * index)) & 0x3F));
+}
+
+static_assert(sdi12_crc_char(0xFC5A, 0) == 'O' && sdi12_crc_char(0xFC5A, 1) == 'q' &&
+                  sdi12_crc_char(0xFC5A, 2) == 'Z',
+              "SDI-12 CRC encoding doesn't match the specification");
+
+/**
+ * Check the CRC of a complete @p response, address, values, CRC and <CR><LF>. If it
+ * matches, the CRC is removed so the values can be parsed as without one. @p Buffer is
+ * an SDI12Buffer or a std::string.
+ */
+template<typename Buffer> bool sdi12_check_crc(Buffer &response) {
+  size_t length = response.length();
+  if (length < 6)
+    return false;
+  size_t crc_at = length - 5;
+  uint16_t crc = sdi12_crc16(response.data(), crc_at);
+  for (uint8_t i = 0; i < 3; i++) {
+    if (response[crc_at + i] != sdi12_crc_char(crc, i))
+      return false;
+  }
+  response.erase(crc_at, 3);
+  return true;
+}
+
+/**
+ * Check the CRC of a complete binary @p packet, the two bytes after the payload, least
+ * significant first. If it matches, the CRC is removed.
+ */
+template<typename Buffer> bool sdi12_check_binary_crc(Buffer &packet) {
+  size_t length = packet.length();
+  if (length < 3)
+    return false;
+  size_t crc_at = length - 2;
+  uint16_t crc = sdi12_crc16(packet.data(), crc_at);
+  if (static_cast<uint8_t>(packet[crc_at]) != (crc & 0xFF) || static_cast<uint8_t>(packet[crc_at + 1]) != crc >> 8)
+    return false;
+  packet.erase(crc_at, 2);
+  return true;
+}
+
+}  // namespace sdi12
+}  // namespace esphome
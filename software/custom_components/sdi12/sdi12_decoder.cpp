@@ -0,0 +1,167 @@
+#include "sdi12_decoder.h"
+
+namespace esphome {
+namespace sdi12 {
+
+uint16_t SDI12EdgeDecoder::bit_times_(uint32_t dt) const {
+  if (dt > MAX_GAP_US)
+    dt = MAX_GAP_US;
+  return (dt * SDI12_BIT_US_DEN + SDI12_BIT_US_NUM / 2) / SDI12_BIT_US_NUM;
+}
+
+// Creates a blank slate of bits for an incoming character
+void SDI12EdgeDecoder::start_char_() {
+  this->rx_state_ = 0x00;  // 0b00000000, got a start bit
+  this->rx_mask_ = 0x01;   // 0b00000001, bit mask, lsb first
+  this->rx_value_ = 0x00;  // 0b00000000, RX character to be, a blank slate
+}
+
+bool SDI12EdgeDecoder::add_bits_(uint16_t rx_bits, uint8_t level, uint8_t &out, bool &next_char_started) {
+  // Calculate how many *data+parity* bits should be left in the current character
+  //      - Each character has a total of 10 bits, 1 start bit, 7 data bits, 1 parity
+  // bit, and 1 stop bit
+  //      - The #rx_state_ holds record of how many of the data + parity bits we've
+  // gotten (up to 8)
+  //      - We have to treat the parity bit as a data bit because we don't know its
+  // state
+  //      - Since we're mid character, we know the start bit is past which knocks us
+  // down to 9
+  //      - There will always be one left over for the stop bit, which will be LOW/1
+  uint8_t bits_left = 9 - this->rx_state_;
+  // If the number of bits passed since the last transition is more than then number
+  // of bits left on the character we were working on, a new character must have
+  // started.
+  // This will happen if the parity bit is 1 or the last bit(s) of the character and
+  // the parity bit are all 1's.
+  next_char_started = (rx_bits > bits_left);
+
+  // Check how many data+parity bits have been sent in this frame.  This will be
+  // different from the rx_bits if a new character has started because of the start
+  // and stop bits.
+  //      - If the total number of bits in this frame is more than the number of
+  // data+parity bits remaining in the character, then the number of data+parity bits
+  // is equal to the number of bits remaining for the character and partiy.
+  //      - If the total number of bits in this frame is less than the number of data
+  // bits left for the character and parity, then the number of data+parity bits
+  // received in this frame is equal to the total number of bits received in this
+  // frame.
+  uint8_t bits_this_frame = next_char_started ? bits_left : rx_bits;
+  // Tick up the rx_state_ by the number of data+parity bits received in the frame
+  this->rx_state_ += bits_this_frame;
+
+  // Set all the bits received between the last change and this change
+  if (level == 0) {
+    // If the current state is spacing (and it just became so), then all bits between
+    // the last change and now must have been marking.
+    // back fill previous bits with 1's
+    while (bits_this_frame-- > 0) {
+      // for each of the bits that happened in this frame
+      this->rx_value_ |= this->rx_mask_;  // Add a 1 to the LSB/right-most place of our
+                                          // character value from the mask
+      this->rx_mask_ = this->rx_mask_ << 1;  // Shift the 1 in the mask up by one position
+    }
+    // And shift the 1 in the mask up by one more position for the current bit.
+    // It's spacing/0 now, so we don't use `|=` with the mask for this last one.
+    this->rx_mask_ = this->rx_mask_ << 1;
+  } else {
+    // If the current state is marking (and it just became so), then this bit is a 1
+    // but all bits between the last change and now must have been spacing/0.
+    this->rx_mask_ = this->rx_mask_ << (bits_this_frame - 1);  // Shift the 1 in the mask up by
+                                                               // the number of bits past
+    this->rx_value_ |= this->rx_mask_;  //  And add that shifted one to the character being created
+  }
+
+  // If this was the 8th or more bit then the character and parity are complete.
+  if (this->rx_state_ > 7) {
+    if (this->binary_) {
+      out = this->rx_value_;  // 8 data bits, nothing to check
+      return true;
+    }
+    // Even parity: the 7 data bits and the parity bit together have an even number of 1's
+    if (__builtin_parity(this->rx_value_))
+      count_(this->parity_errors_);
+    out = this->rx_value_ & 0x7F;  // Strip the parity bit (and with 0b01111111)
+    return true;
+  }
+  return false;
+}
+
+bool SDI12EdgeDecoder::feed(uint32_t time, uint8_t level, uint8_t &out) {
+  bool complete = false;
+
+  // Check if we're ready for a start bit, and if this could possibly be it.
+  if (this->rx_state_ == WAITING_FOR_START_BIT) {
+    // If we are waiting for a start bit and the pin is marking it's not a start bit
+    if (level != 0) {
+      // A character completed by its spacing parity bit still needs its stop bit, the
+      // line has to turn marking one bit later
+      if (this->stop_pending_ && this->bit_times_(time - this->prev_time_) > 1)
+        count_(this->framing_errors_);
+      this->stop_pending_ = false;
+      this->prev_level_ = level;
+      return false;
+    }
+    // If the pin is spacing, this should be a start bit.
+    // Thus start_char_(), which sets the rx_state_ to 0, create an empty character, and
+    // a new mask with a 1 in the lowest place
+    this->start_char_();
+  } else {
+    // If we're not waiting for a start bit, it's because we're in the middle of an
+    // incomplete character and therefore this change in the pin state must be from a
+    // data, parity, or stop bit.
+
+    // Check how many bit times have passed since the last change
+    uint16_t rx_bits = this->bit_times_(time - this->prev_time_);
+    // A level that lasted less than half a bit is a bit shortened by jitter, there are no
+    // empty bits.  If it was noise instead, the parity check catches the damage.
+    if (rx_bits == 0)
+      rx_bits = 1;
+    bool next_char_started;
+    complete = this->add_bits_(rx_bits, level, out, next_char_started);
+
+    if (complete) {
+      // Switching to spacing after the parity bit, right where the stop bit should be,
+      // means there was no stop bit (marking) at all.  So does spacing that began before
+      // and only ends after it.
+      if (level == 0 && !next_char_started && this->rx_state_ > 8)
+        count_(this->framing_errors_);
+      if (level != 0 && next_char_started)
+        count_(this->framing_errors_);
+      this->stop_pending_ = level == 0 && !next_char_started && this->rx_state_ == 8;
+
+      // if this is marking, or we haven't exceeded the number of bits in a character
+      // (but have gotten all the data bits) then this should be a stop bit and we can
+      // start looking for a new start bit.
+      if ((level != 0) || !next_char_started) {
+        this->rx_state_ = WAITING_FOR_START_BIT;  // DISABLE STOP BIT TIMER
+      } else {
+        // If we just switched to spacing, or we've exceeded the total number of bits in
+        // a character, then the character must have ended with 1's/marking, and this
+        // new 0/spacing is actually the start bit of the next character.
+        this->start_char_();
+      }
+    }
+  }
+  this->prev_time_ = time;  // finally remember time stamp of this change!
+  this->prev_level_ = level;
+  return complete;
+}
+
+bool SDI12EdgeDecoder::flush(uint32_t time, uint8_t &out) {
+  if (this->rx_state_ == WAITING_FOR_START_BIT)
+    return false;
+
+  uint16_t rx_bits = this->bit_times_(time - this->prev_time_);
+  if (rx_bits <= 9 - this->rx_state_)
+    return false;  // the character may still be going on
+
+  // The line stayed at its level for longer than the rest of the character.  If that is
+  // marking, the remaining bits were 1's, as if the next start bit had arrived now.
+  bool next_char_started;
+  bool complete = this->prev_level_ != 0 && this->add_bits_(rx_bits, 0, out, next_char_started);
+  this->rx_state_ = WAITING_FOR_START_BIT;
+  return complete;
+}
+
+}  // namespace sdi12
+}  // namespace esphome
@@ -0,0 +1,181 @@
+/**
+ * @file sdi12_decoder.h
+ *
+ * @brief Reconstruction of SDI-12 characters from the transitions of the data line.
+ *
+ * The decoder does not touch any hardware: it is fed the time and the new level of each
+ * edge on the Rx pin, either directly from the interrupt service routine or later from
+ * a queue of recorded edges.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace esphome {
+namespace sdi12 {
+
+/**
+ * @brief The duration of one bit at 1200 baud, 2500/3 µs (833.33 µs)
+ *
+ * Kept as a fraction so that neither bit counts nor bit positions within a character
+ * accumulate rounding errors.
+ */
+static const uint32_t SDI12_BIT_US_NUM = 2500;
+static const uint32_t SDI12_BIT_US_DEN = 3;
+
+/// The time from the start of a character to the end of its bit number @p bits, in µs
+inline uint32_t sdi12_bits_to_micros(uint32_t bits) {
+  return (bits * SDI12_BIT_US_NUM + SDI12_BIT_US_DEN / 2) / SDI12_BIT_US_DEN;
+}
+
+/**
+ * @brief Flags for what went wrong on the line, per character and per transaction
+ */
+enum SDI12LineError : uint8_t {
+  SDI12_LINE_OK = 0,
+  /** The data and parity bits of a character have odd parity */
+  SDI12_PARITY_ERROR = 1 << 0,
+  /** The stop bit of a character was spacing */
+  SDI12_FRAMING_ERROR = 1 << 1,
+  /** A character or a transition was lost to a full buffer */
+  SDI12_OVERFLOW_ERROR = 1 << 2,
+};
+
+/**
+ * @brief Cumulative counts of line errors
+ */
+struct SDI12LineCounters {
+  uint32_t parity_errors;
+  uint32_t framing_errors;
+  uint32_t overflows;
+};
+
+/**
+ * @brief A transition of the Rx pin as recorded by the interrupt service routine
+ */
+struct SDI12Edge {
+  /** The timer value when the transition happened, in µs */
+  uint32_t time;
+  /** The level of the Rx pin after the transition */
+  uint8_t level;
+};
+
+/**
+ * @brief Turns the transitions of the Rx line into characters
+ *
+ * A character is 10 bits, 1 start bit, 7 data bits (least significant bit first), 1
+ * even parity bit and 1 stop bit.  In binary mode the parity bit is the 8th data bit.
+ * On the Rx pin a HIGH level is marking (1) and a LOW level is spacing (0).  Instead of
+ * sampling each bit, the decoder looks at the time between two transitions, derives how
+ * many bits have the level that just ended, and fills them into the character being built.
+ *
+ * The decoder holds all the reception state of one data line, so there is one instance
+ * per SDI-12 object.
+ */
+class SDI12EdgeDecoder {
+ public:
+  /// Drop any partial character and wait for the next start bit
+  void reset() {
+    this->rx_state_ = WAITING_FOR_START_BIT;
+    this->stop_pending_ = false;
+  }
+  /**
+   * Receive 8 data bits without parity, as in the packets of the high-volume binary
+   * command, instead of 7 data bits with even parity
+   */
+  void set_binary(bool binary) { this->binary_ = binary; }
+
+  /**
+   * @brief Process one transition of the Rx line
+   *
+   * @param time The timer value of the transition, in µs
+   * @param level The level of the Rx pin after the transition
+   * @param out Receives the character if this transition completed one
+   * @return true if a character was completed, even with a parity or framing error
+   */
+  bool feed(uint32_t time, uint8_t level, uint8_t &out);
+
+  /**
+   * @brief Complete a character whose last bits are marking
+   *
+   * When the parity bit and the last data bits of a character are 1, there is no
+   * transition at the end of it and the character is only completed by the start bit of
+   * the next one.  For the last character of a transmission, this completes it once
+   * enough time has passed for the whole character.
+   *
+   * @param time The current timer value, in µs
+   * @param out Receives the character if one was completed
+   * @return true if a character was completed
+   */
+  bool flush(uint32_t time, uint8_t &out);
+
+  /** Characters received with odd parity since construction */
+  uint32_t parity_errors() const { return this->parity_errors_.load(std::memory_order_relaxed); }
+  /** Characters without a stop bit since construction */
+  uint32_t framing_errors() const { return this->framing_errors_.load(std::memory_order_relaxed); }
+
+ protected:
+  /** A value of #rx_state_ while waiting for a start bit; 0b11111111 */
+  static const uint8_t WAITING_FOR_START_BIT = 0xFF;
+
+  /** Gaps longer than this only tell that the character is over, 0.1 s = 120 bits */
+  static const uint32_t MAX_GAP_US = 100000;
+
+  /**
+   * @brief Calculate the number of bit-times that have elapsed between two transitions
+   *
+   * The time difference in µs is divided by the exact bit time and rounded to the
+   * nearest bit, so an edge may be early or late by almost half a bit (416 µs) before
+   * a bit is gained or lost.  As only the difference of two 32-bit timestamps is used,
+   * it is correct across the wrap-around of micros().
+   */
+  uint16_t bit_times_(uint32_t dt) const;
+  /** Create a blank slate for a new incoming character */
+  void start_char_();
+  /**
+   * @brief Account for the bits between the previous and this transition
+   *
+   * @return true if the character is complete, its value is then in @p out and its
+   * parity is checked
+   */
+  bool add_bits_(uint16_t rx_bits, uint8_t level, uint8_t &out, bool &next_char_started);
+
+  /** The time of the previous Rx transition */
+  uint32_t prev_time_{0};
+  /** The level of the Rx pin after the previous transition */
+  uint8_t prev_level_{1};
+  /**
+   * @brief Tracks how many bits are accounted for on an incoming character.
+   *
+   * - if 0: indicates that we got a start bit
+   * - if >0: indicates the number of bits received
+   */
+  uint8_t rx_state_{WAITING_FOR_START_BIT};
+  /**
+   * @brief A bit mask for building a received character
+   *
+   * The mask has a single bit set, in the place of the active bit based on the
+   * #rx_state_.
+   */
+  uint8_t rx_mask_{0};
+  /** The value of the character being built */
+  uint8_t rx_value_{0};
+  /** The last character was completed by its spacing parity bit, its stop bit is still due */
+  bool stop_pending_{false};
+  /** 8N1 instead of 7E1 */
+  bool binary_{false};
+  /**
+   * Only the decoder writes the counters, from the ISR or the main loop, so plain
+   * atomic loads and stores suffice for readers in the other context.
+   */
+  static void count_(std::atomic<uint32_t> &counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+  std::atomic<uint32_t> parity_errors_{0};
+  std::atomic<uint32_t> framing_errors_{0};
+};
+
+}  // namespace sdi12
+}  // namespace esphome
@@ -0,0 +1,161 @@
+#include "sdi12_emulator.h"
+
+#ifdef USE_SDI12_EMULATOR
+
+#include <algorithm>
+#include <cstdio>
+#include "sdi12_crc.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#ifdef USE_HOST
+#include "sdi12_host.h"
+#endif
+
+namespace esphome {
+namespace sdi12 {
+
+// Values per aM! and aC! measurement
+static const size_t MEASURE_MAX_VALUES = 9;
+static const size_t CONCURRENT_MAX_VALUES = 99;
+// Characters of values per data page, after aM! and after aC! or aRn!
+static const size_t MEASURE_PAGE_LENGTH = 35;
+static const size_t CONCURRENT_PAGE_LENGTH = 75;
+
+static void append_crc(std::string &response) {
+  uint16_t crc = sdi12_crc16(response.data(), response.length());
+  for (uint8_t i = 0; i < 3; i++)
+    response += sdi12_crc_char(crc, i);
+}
+
+// The values that make up data page @p page: the pages are filled in order, a value that
+// doesn't fit goes to the next one
+static void append_page(const std::vector<float> &values, const std::vector<SDI12EmulatedValue> &config,
+                        size_t count, uint8_t page, size_t page_length, std::string &response) {
+  uint8_t current = 0;
+  size_t length = 0;
+  char text[24];
+  for (size_t i = 0; i < count && current <= page; i++) {
+    int size = snprintf(text, sizeof(text), "%+.*f", config[i].decimals, values[i]);
+    if (size <= 0)
+      continue;
+    if (length > 0 && length + size > page_length) {
+      current++;
+      length = 0;
+    }
+    length += size;
+    if (current == page)
+      response.append(text, size);
+  }
+}
+
+bool SDI12EmulatedSensor::handle_command(const std::string &command, std::string &response, uint32_t &latency_us) {
+  if (command.length() < 2 || command.back() != '!')
+    return false;
+  // ?! is for everybody on the line
+  if (command != "?!" && command[0] != this->address_)
+    return false;
+  if (!this->respond_(command.substr(1, command.length() - 2), response))
+    return false;
+
+  if (this->drop_rate_ > 0.0f && random_float() < this->drop_rate_) {
+    this->dropped_++;
+    return false;
+  }
+  // one bit of a character between the address and the <CR><LF>
+  if (this->corrupt_rate_ > 0.0f && response.length() > 3 && random_float() < this->corrupt_rate_) {
+    response[1 + random_uint32() % (response.length() - 3)] ^= 0x01;
+    this->corrupted_++;
+  }
+  this->answered_++;
+  latency_us = this->latency_us_;
+  return true;
+}
+
+bool SDI12EmulatedSensor::respond_(const std::string &body, std::string &response) {
+  response.assign(1, this->address_);
+  bool crc = false;
+
+  if (body.empty()) {
+    // acknowledge active
+  } else if (body == "I") {
+    response += "14" + this->identification_;
+  } else if (body.length() == 2 && body[0] == 'A' && isalnum(static_cast<unsigned char>(body[1]))) {
+    this->address_ = body[1];
+    response.assign(1, this->address_);
+  } else if (body[0] == 'M' || body[0] == 'C') {
+    size_t at = 1;
+    bool with_crc = at < body.length() && body[at] == 'C';
+    if (with_crc)
+      at++;
+    // aM! or aM1! ... aM9!, every index measures the same values here
+    if (at < body.length() && !(body.length() == at + 1 && body[at] >= '1' && body[at] <= '9'))
+      return false;
+    this->start_measurement_(body[0] == 'C', with_crc, response);
+  } else if (body.length() == 2 && body[0] == 'D' && isdigit(static_cast<unsigned char>(body[1]))) {
+    crc = this->crc_;
+    // an aC! that is still measuring has no data yet
+    if (static_cast<int32_t>(micros() - this->ready_at_) >= 0) {
+      append_page(this->measured_, this->values_, this->measured_count_, body[1] - '0',
+                  this->concurrent_ ? CONCURRENT_PAGE_LENGTH : MEASURE_PAGE_LENGTH, response);
+    }
+  } else if (body[0] == 'R') {
+    size_t at = 1;
+    crc = at < body.length() && body[at] == 'C';
+    if (crc)
+      at++;
+    if (body.length() != at + 1 || !isdigit(static_cast<unsigned char>(body[at])))
+      return false;
+    // continuous measurements leave the data of aM! and aC! alone
+    std::vector<float> values;
+    this->measure_(values);
+    append_page(values, this->values_, values.size(), 0, CONCURRENT_PAGE_LENGTH, response);
+  } else {
+    return false;
+  }
+
+  if (crc)
+    append_crc(response);
+  response += "\r\n";
+  return true;
+}
+
+void SDI12EmulatedSensor::start_measurement_(bool concurrent, bool crc, std::string &response) {
+  this->measure_(this->measured_);
+  this->measured_count_ = std::min(this->values_.size(), concurrent ? CONCURRENT_MAX_VALUES : MEASURE_MAX_VALUES);
+  this->concurrent_ = concurrent;
+  this->crc_ = crc;
+
+  uint32_t seconds = std::min<uint32_t>((this->measurement_time_ms_ + 999) / 1000, 999);
+  char text[8];
+  snprintf(text, sizeof(text), concurrent ? "%03u%02u" : "%03u%u", static_cast<unsigned>(seconds),
+           static_cast<unsigned>(this->measured_count_));
+  response += text;
+
+  // the measurement starts once the response is out, and is over with its service request
+  // sent well before the announced ttt, when the recorder asks for the data
+  uint32_t measuring_us = this->measurement_time_ms_ * 1000;
+  if (seconds > 0)
+    measuring_us = std::min(measuring_us, seconds * 1000000 - 100000);
+  uint32_t until_ready = this->latency_us_ + (response.length() + 2) * SDI12_CHARACTER_US + measuring_us;
+  this->ready_at_ = micros() + until_ready;
+  // a new measurement aborts the last one, and with it its service request
+  if (this->phy_ != nullptr)
+    this->phy_->cancel(this->address_);
+  // an aM! with ttt > 0 reports the end of the measurement with a service request
+  if (!concurrent && seconds > 0 && this->phy_ != nullptr)
+    this->phy_->transmit(std::string(1, this->address_) + "\r\n", until_ready);
+}
+
+void SDI12EmulatedSensor::measure_(std::vector<float> &values) {
+  values.resize(this->values_.size());
+  for (size_t i = 0; i < this->values_.size(); i++) {
+    const SDI12EmulatedValue &value = this->values_[i];
+    values[i] = value.base + value.step * this->measurements_ + value.noise * (2.0f * random_float() - 1.0f);
+  }
+  this->measurements_++;
+}
+
+}  // namespace sdi12
+}  // namespace esphome
+
+#endif
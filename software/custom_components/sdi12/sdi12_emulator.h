@@ -0,0 +1,109 @@
+/**
+ * @file sdi12_emulator.h
+ *
+ * @brief An emulated SDI-12 sensor on a SDI12LoopbackPhy, set up from YAML.
+ *
+ * It answers the basic command set of the specification with generated values, so the
+ * scheduler, the scan and the parsing can be watched with as many sensors on one line as
+ * the address space allows, on the host as well as on a device without a sensor attached.
+ * Only built with USE_SDI12_EMULATOR, the firmware of a bus on its pins leaves it out.
+ */
+
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_SDI12_EMULATOR
+
+#include <string>
+#include <vector>
+#include "sdi12_phy_loopback.h"
+
+namespace esphome {
+namespace sdi12 {
+
+/// A value of the emulated sensor: base, plus step for every measurement, plus uniform noise within ±noise
+struct SDI12EmulatedValue {
+  float base;
+  float step;
+  float noise;
+  uint8_t decimals;
+};
+
+/**
+ * @brief Answers a!, aI!, aAb!, aM!, aC!, aD0! ... aD9! and aR0! ... aR9!, each with or
+ * without CRC, and ?! like a sensor alone on the line.
+ *
+ * aM! and aC! return ttt for the measurement time and the number of values; an aM! is
+ * followed by a service request once its values are ready.  The data is split into pages
+ * of at most 35 (aM!) or 75 (aC!) characters.  Responses can be dropped or corrupted at a
+ * given rate to exercise the retries.
+ */
+class SDI12EmulatedSensor : public SDI12SimulatedSensor {
+ public:
+  /// The line the sensor is on, it transmits its service requests there
+  void set_phy(SDI12LoopbackPhy *phy) {
+    this->phy_ = phy;
+    phy->add_sensor(this);
+  }
+  void set_address(char address) { this->address_ = address; }
+  /// The part of the aI! response after the SDI-12 version: vendor, model, version, serial
+  void set_identification(const std::string &identification) { this->identification_ = identification; }
+  /// time from aM!/aC! until the values are ready, announced rounded up to seconds
+  void set_measurement_time(uint32_t measurement_time_ms) { this->measurement_time_ms_ = measurement_time_ms; }
+  /// time from the end of a command to the start bit of the response
+  void set_latency(uint32_t latency_ms) { this->latency_us_ = latency_ms * 1000; }
+  /// time the sensor needs after a break before it hears a command
+  void set_wake_time(uint32_t wake_time_ms) { this->wake_time_us_ = wake_time_ms * 1000; }
+  /// share of the responses that are never sent
+  void set_drop_rate(float drop_rate) { this->drop_rate_ = drop_rate; }
+  /// share of the responses with one character changed on the way
+  void set_corrupt_rate(float corrupt_rate) { this->corrupt_rate_ = corrupt_rate; }
+  void add_value(float base, float step, float noise, uint8_t decimals) {
+    this->values_.push_back({base, step, noise, decimals});
+  }
+
+  bool handle_command(const std::string &command, std::string &response, uint32_t &latency_us) override;
+  uint32_t wake_time_us() const override { return this->wake_time_us_; }
+
+  char get_address() const { return this->address_; }
+  /// commands answered, dropped and corrupted since boot
+  uint32_t get_answered() const { return this->answered_; }
+  uint32_t get_dropped() const { return this->dropped_; }
+  uint32_t get_corrupted() const { return this->corrupted_; }
+
+ protected:
+  /// The response to @p body, the command without its address and '!'; false for no answer
+  bool respond_(const std::string &body, std::string &response);
+  /// Start an aM! or aC! measurement, the response is atttn or atttnn
+  void start_measurement_(bool concurrent, bool crc, std::string &response);
+  /// Sample every value once into @p values
+  void measure_(std::vector<float> &values);
+
+  SDI12LoopbackPhy *phy_{nullptr};
+  char address_{'0'};
+  std::string identification_;
+  std::vector<SDI12EmulatedValue> values_;
+  /// the values of the last measurement, and how many of them the data pages return
+  std::vector<float> measured_;
+  size_t measured_count_{0};
+  uint32_t measurements_{0};
+  /// micros() at which the values of the running measurement are ready
+  uint32_t ready_at_{0};
+  uint32_t measurement_time_ms_{1000};
+  uint32_t latency_us_{9000};
+  uint32_t wake_time_us_{0};
+  float drop_rate_{0.0f};
+  float corrupt_rate_{0.0f};
+  /// whether the last measurement was an aC!, and whether its data pages carry a CRC
+  bool concurrent_{false};
+  bool crc_{false};
+  uint32_t answered_{0};
+  uint32_t dropped_{0};
+  uint32_t corrupted_{0};
+};
+
+}  // namespace sdi12
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,180 @@
+/**
+ * @file sdi12_host.h
+ *
+ * @brief A virtual clock and virtual pins for running the SDI-12 code on the host
+ * platform of ESPHome (USE_HOST), in place of the Arduino core.
+ *
+ * Everything in here lives in the sdi12 namespace, so it shadows esphome::millis() and
+ * esphome::micros() for the SDI-12 code only: the bus, the bit-banged line and the
+ * loopback all run on the virtual clock, while the rest of ESPHome keeps real time.
+ * Time only moves when it is advanced, or by a small step on every read of the clock
+ * so the busy waits of the bit-banged line terminate.  Protocol timing is therefore
+ * deterministic and runs as fast as the host can compute it.
+ *
+ * A test or benchmark installs its own SDI12HostHal with set_sdi12_host_hal() to
+ * watch the Tx pin or to drive the Rx pin like a sensor would.
+ */
+
+#pragma once
+
+#ifdef USE_HOST
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifndef HIGH
+#define HIGH 0x1
+#define LOW 0x0
+#endif
+#ifndef INPUT
+#define INPUT 0x0
+#define OUTPUT 0x1
+#endif
+#ifndef CHANGE
+#define CHANGE 0x3
+#endif
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#ifndef ICACHE_RAM_ATTR
+#define ICACHE_RAM_ATTR
+#endif
+
+namespace esphome {
+namespace sdi12 {
+
+/// Pins a virtual board has
+static const uint8_t SDI12_HOST_PINS = 64;
+
+class SDI12HostHal {
+ public:
+  virtual ~SDI12HostHal() = default;
+
+  /// The virtual time in µs, each read moves it by the read step
+  virtual uint32_t micros() {
+    uint64_t now = this->now_us_;
+    this->now_us_ += this->read_step_us_;
+    return static_cast<uint32_t>(now);
+  }
+  virtual uint32_t millis() {
+    uint64_t now = this->now_us_;
+    this->now_us_ += this->read_step_us_;
+    return static_cast<uint32_t>(now / 1000);
+  }
+  /// Waiting moves the clock right away
+  virtual void delay_us(uint32_t us) { this->advance(us); }
+  void advance(uint32_t us) { this->now_us_ += us; }
+  uint64_t now_us() const { return this->now_us_; }
+  /// how far each read of micros() moves the clock, 0 freezes it between advance() calls
+  void set_read_step(uint32_t us) { this->read_step_us_ = us; }
+
+  virtual void pin_mode(uint8_t pin, uint8_t mode) {}
+  /// An output, as set by the SDI-12 code
+  virtual void digital_write(uint8_t pin, uint8_t level) { this->levels_[pin % SDI12_HOST_PINS] = level; }
+  virtual int digital_read(uint8_t pin) { return this->levels_[pin % SDI12_HOST_PINS]; }
+  /// An input driven from outside, its interrupt handler runs on every change
+  void set_input(uint8_t pin, uint8_t level) {
+    pin %= SDI12_HOST_PINS;
+    if (this->levels_[pin] == level)
+      return;
+    this->levels_[pin] = level;
+    if (this->handlers_[pin] == nullptr)
+      return;
+    if (this->interrupts_masked_) {
+      this->pending_[pin] = true;
+    } else {
+      this->handlers_[pin](this->handler_args_[pin]);
+    }
+  }
+  /// Hold off the interrupt handlers, a change in between runs its handler once unmasked
+  virtual void mask_interrupts() { this->interrupts_masked_ = true; }
+  void unmask_interrupts() {
+    this->interrupts_masked_ = false;
+    for (uint8_t pin = 0; pin < SDI12_HOST_PINS; pin++) {
+      if (!this->pending_[pin])
+        continue;
+      this->pending_[pin] = false;
+      if (this->handlers_[pin] != nullptr)
+        this->handlers_[pin](this->handler_args_[pin]);
+    }
+  }
+  void attach_interrupt(uint8_t pin, void (*handler)(void *), void *arg) {
+    this->handlers_[pin % SDI12_HOST_PINS] = handler;
+    this->handler_args_[pin % SDI12_HOST_PINS] = arg;
+  }
+  void detach_interrupt(uint8_t pin) { this->handlers_[pin % SDI12_HOST_PINS] = nullptr; }
+
+ protected:
+  uint64_t now_us_{0};
+  uint32_t read_step_us_{1};
+  uint8_t levels_[SDI12_HOST_PINS]{};
+  void (*handlers_[SDI12_HOST_PINS])(void *){};
+  void *handler_args_[SDI12_HOST_PINS]{};
+  bool pending_[SDI12_HOST_PINS]{};
+  bool interrupts_masked_{false};
+};
+
+inline SDI12HostHal *&sdi12_host_hal_slot() {
+  static SDI12HostHal default_hal;
+  static SDI12HostHal *hal = &default_hal;
+  return hal;
+}
+/// The virtual board all SDI-12 code on the host runs on
+inline SDI12HostHal &sdi12_host_hal() { return *sdi12_host_hal_slot(); }
+/// Replace the virtual board, before the bus is set up
+inline void set_sdi12_host_hal(SDI12HostHal *hal) { sdi12_host_hal_slot() = hal; }
+
+// The part of the Arduino core the SDI-12 code uses
+inline uint32_t micros() { return sdi12_host_hal().micros(); }
+inline uint32_t millis() { return sdi12_host_hal().millis(); }
+inline void delayMicroseconds(uint32_t us) { sdi12_host_hal().delay_us(us); }
+inline void delay(uint32_t ms) { sdi12_host_hal().delay_us(ms * 1000); }
+inline void yield() {}
+inline void pinMode(uint8_t pin, uint8_t mode) { sdi12_host_hal().pin_mode(pin, mode); }
+inline void digitalWrite(uint8_t pin, uint8_t level) { sdi12_host_hal().digital_write(pin, level); }
+inline int digitalRead(uint8_t pin) { return sdi12_host_hal().digital_read(pin); }
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {
+  sdi12_host_hal().attach_interrupt(pin, handler, arg);
+}
+inline void detachInterrupt(uint8_t pin) { sdi12_host_hal().detach_interrupt(pin); }
+inline void noInterrupts() { sdi12_host_hal().mask_interrupts(); }
+inline void interrupts() { sdi12_host_hal().unmask_interrupts(); }
+
+/// Arduino's String, as far as the SDI12 class needs it
+class String : public std::string {
+ public:
+  using std::string::string;
+  String(const std::string &text) : std::string(text) {}  // NOLINT
+  String(char c) : std::string(1, c) {}                    // NOLINT
+};
+
+/// Strings in flash are ordinary strings on the host
+class __FlashStringHelper;
+inline size_t strlen_P(const char *text) { return std::strlen(text); }
+inline uint8_t pgm_read_byte(const char *address) { return *address; }
+#ifndef PGM_P
+#define PGM_P const char *
+#endif
+
+/// Arduino's Stream, the interface of the SDI12 class
+class Stream {
+ public:
+  virtual ~Stream() = default;
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() = 0;
+  virtual size_t write(uint8_t byte) = 0;
+  void setTimeout(unsigned long timeout) { this->_timeout = timeout; }
+
+ protected:
+  unsigned long _timeout{1000};
+};
+
+}  // namespace sdi12
+}  // namespace esphome
+
+#endif  // USE_HOST
@@ -0,0 +1,79 @@
+/**
+ * @file sdi12_perf.h
+ *
+ * @brief Counters of the time spent in the hot paths of a bus: the Rx interrupt, the edge
+ * decoding, the transaction state machine, the CRC check and the value parser.
+ *
+ * They read the cycle counter of the CPU, a few instructions per measurement, so they can
+ * be switched on in the field (`performance_counters: true`) and a regression shows up in
+ * the statistics of a running node.  On the host they count nanoseconds of real time.
+ */
+
+#pragma once
+
+#include <cstdint>
+#ifdef USE_HOST
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+
+namespace esphome {
+namespace sdi12 {
+
+/// The cycle counter of the CPU, safe to read from an interrupt
+inline uint32_t sdi12_cycle_count() {
+#if defined(USE_HOST)
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+#elif defined(USE_ESP32) || defined(USE_ESP8266)
+  return ESP.getCycleCount();
+#else
+  return micros();
+#endif
+}
+
+/// Counts of sdi12_cycle_count() per µs
+inline uint32_t sdi12_cycles_per_us() {
+#if defined(USE_HOST)
+  return 1000;
+#elif defined(USE_ESP32) || defined(USE_ESP8266)
+  return ESP.getCpuFreqMHz();
+#else
+  return 1;
+#endif
+}
+
+/**
+ * @brief Calls of one code path and the cycles they took
+ *
+ * The counts run since boot and wrap, the difference of two snapshots gives the calls and
+ * cycles in between.
+ */
+struct SDI12PerfCounter {
+  uint32_t calls{0};
+  uint32_t cycles{0};
+  /// the longest call since boot
+  uint32_t max_cycles{0};
+
+  /// Count a call that started at @p start, a value of sdi12_cycle_count()
+  void add(uint32_t start) {
+    uint32_t cycles = sdi12_cycle_count() - start;
+    this->calls++;
+    this->cycles += cycles;
+    if (cycles > this->max_cycles)
+      this->max_cycles = cycles;
+  }
+};
+
+/// All counters of a bus
+struct SDI12PerfCounters {
+  SDI12PerfCounter rx_interrupt;  ///< the Rx interrupt, per edge
+  SDI12PerfCounter rx_decode;     ///< edges recorded by the interrupt decoded in the main loop, per edge
+  SDI12PerfCounter transaction;   ///< the transaction state machine, per SDI12Bus::loop() call
+  SDI12PerfCounter crc;           ///< the CRC check, per response
+  SDI12PerfCounter parse;         ///< the value parser, per data page
+};
+
+}  // namespace sdi12
+}  // namespace esphome
@@ -0,0 +1,84 @@
+/**
+ * @file sdi12_phy.h
+ *
+ * @brief The physical layer of an SDI-12 bus, as seen by the protocol code in SDI12Bus.
+ *
+ * A PHY owns the data line: it produces the wake-up break and the marking, puts the
+ * characters of a command on the line and hands back the characters of the response.
+ * SDI12Bus only sequences these steps and times them, so a different transport (the
+ * bit-banged pins of SDI12BitBangPhy, a hardware UART, a simulation on the host) is a
+ * matter of implementing this interface.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "sdi12_decoder.h"
+#include "sdi12_perf.h"
+
+namespace esphome {
+namespace sdi12 {
+
+/// Duration of one character on the line: 10 bits at 1200 baud
+static const uint32_t SDI12_CHARACTER_US = 8334;
+/// The break that wakes the sensors, at least 12 ms
+static const uint32_t SDI12_BREAK_US = 12300;
+/// The marking between the break and a command, at least 8.33 ms
+static const uint32_t SDI12_MARKING_US = 8500;
+/// A command needs no break while the line was active within the last 87 ms
+static const uint32_t SDI12_ACTIVITY_WINDOW_US = 87000;
+/// The characters of a command follow each other with at most 1.66 ms of marking
+static const uint32_t SDI12_CHARACTER_GAP_US = 1660;
+
+class SDI12Phy {
+ public:
+  virtual ~SDI12Phy() = default;
+
+  /// Prepare the hardware, called once from SDI12Bus::setup()
+  virtual void setup() {}
+
+  /**
+   * Take over the data line, SDI12Bus does this once after setup() and keeps it. A PHY
+   * must not depend on other instances, every bus drives its own line at the same time.
+   */
+  virtual void begin() = 0;
+  /// Release the data line, nothing is received until the next begin()
+  virtual void end() = 0;
+
+  /// Pull the line to spacing to wake the sensors, SDI12Bus times the duration
+  virtual void send_break() = 0;
+  /// Pull the line to marking after the break, or without one, SDI12Bus times the duration
+  virtual void send_marking() = 0;
+  /**
+   * Put the next character of a command on the line, 7E1 at 1200 baud. Returns once its
+   * stop bit was sent, SDI12Bus sends the following one within #SDI12_CHARACTER_GAP_US.
+   */
+  virtual void send_char(char c) = 0;
+  /// The command is complete, switch to listening, the response timeout starts right after
+  virtual void end_frame() = 0;
+  /// Listen without transmitting first, e.g. for a service request
+  virtual void listen() = 0;
+  /// Receive 8N1 bytes of a binary packet instead of 7E1 characters, until switched back
+  virtual void set_binary(bool binary) = 0;
+
+  /// Number of received characters waiting, -1 if some were lost to an overflow
+  virtual int available() = 0;
+  /// Move up to @p length received characters to @p buffer, returns how many were moved
+  virtual size_t read(uint8_t *buffer, size_t length) = 0;
+  /// Drop all received characters and the overflow status
+  virtual void clear() = 0;
+  /// micros() at which the most recent character was completed on the line
+  virtual uint32_t last_receive_time() const = 0;
+  /// micros() at the end of the most recent character on the line, in either direction
+  virtual uint32_t last_activity_time() const = 0;
+  /// Cumulative parity errors, framing errors and overflows of the receiver
+  virtual SDI12LineCounters line_counters() const = 0;
+  /// Measure the time spent receiving, if the PHY can
+  virtual void set_performance_counters(bool enabled) {}
+  /// Fill in the Rx interrupt and decoding counters of @p counters, if the PHY measures them
+  virtual void rx_performance_counters(SDI12PerfCounters &counters) const {}
+};
+
+}  // namespace sdi12
+}  // namespace esphome
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "sdi12_bus.h"
+#include "sdi12_phy.h"
+
+namespace esphome {
+namespace sdi12 {
+
+/**
+ * The SDI-12 line driven by software: the Tx and output-enable pins are toggled with
+ * busy-waited bit timing and the characters are reconstructed from the edges on the
+ * Rx pin by the SDI12 class.
+ */
+class SDI12BitBangPhy : public SDI12Phy {
+ public:
+  void set_pins(int8_t rx_pin, int8_t tx_pin, int8_t oe_pin) {
+    this->rx_pin_ = rx_pin;
+    this->tx_pin_ = tx_pin;
+    this->oe_pin_ = oe_pin;
+  }
+  /// only record Rx transitions in the interrupt and decode them in the main loop
+  void set_deferred_decoding(bool deferred_decoding) { this->sdi12_.setDeferredDecoding(deferred_decoding); }
+
+  void setup() override { this->sdi12_.setDataPin(this->rx_pin_, this->tx_pin_, this->oe_pin_); }
+  void begin() override { this->sdi12_.begin(); }
+  void end() override { this->sdi12_.end(); }
+  void send_break() override { this->sdi12_.beginBreak(); }
+  void send_marking() override { this->sdi12_.beginMarking(); }
+  void send_char(char c) override { this->sdi12_.sendChar(c); }
+  void end_frame() override {
+    this->sdi12_.endFrame();
+    // the Rx pin sees our own characters
+    this->sdi12_.clearBuffer();
+  }
+  void listen() override { this->sdi12_.forceListen(); }
+  void set_binary(bool binary) override { this->sdi12_.setBinaryMode(binary); }
+  int available() override { return this->sdi12_.available(); }
+  size_t read(uint8_t *buffer, size_t length) override { return this->sdi12_.read(buffer, length); }
+  void clear() override { this->sdi12_.clearBuffer(); }
+  uint32_t last_receive_time() const override { return this->sdi12_.getLastRxMicros(); }
+  uint32_t last_activity_time() const override { return this->sdi12_.getLastActivityMicros(); }
+  SDI12LineCounters line_counters() const override { return this->sdi12_.getLineCounters(); }
+  void set_performance_counters(bool enabled) override { this->sdi12_.setPerformanceCounters(enabled); }
+  void rx_performance_counters(SDI12PerfCounters &counters) const override {
+    counters.rx_interrupt = this->sdi12_.getInterruptCounter();
+    counters.rx_decode = this->sdi12_.getDecodeCounter();
+  }
+
+ protected:
+  SDI12 sdi12_;
+  int8_t rx_pin_{-1};
+  int8_t tx_pin_{-1};
+  int8_t oe_pin_{-1};
+};
+
+}  // namespace sdi12
+}  // namespace esphome
@@ -0,0 +1,143 @@
+#include "sdi12_phy_loopback.h"
+
+#ifdef USE_SDI12_EMULATOR
+
+#include <algorithm>
+#include "esphome/core/hal.h"
+#ifdef USE_HOST
+#include "sdi12_host.h"
+#endif
+
+namespace esphome {
+namespace sdi12 {
+
+// A break of at least 12 ms wakes the sensors
+static const uint32_t WAKE_BREAK_US = 12000;
+// Sensors go back to sleep after 100 ms of marking without a command
+static const uint32_t SLEEP_US = 100000;
+
+bool SDI12LoopbackPhy::is_awake(char address, uint32_t now) const {
+  if (this->awake_ != AWAKE_ALL && this->awake_ != address)
+    return false;
+  return !this->in_break_ && now - this->last_activity_ < SLEEP_US;
+}
+
+void SDI12LoopbackPhy::send_break() {
+  // the break resets the sensors, one that is still answering stops
+  this->deliver_(micros());
+  this->in_flight_.clear();
+  this->in_break_ = true;
+  this->break_started_ = micros();
+}
+
+void SDI12LoopbackPhy::send_marking() {
+  // marking without a break leaves the sensors as they are
+  if (!this->in_break_)
+    return;
+  uint32_t now = micros();
+  this->awake_ = now - this->break_started_ >= WAKE_BREAK_US ? AWAKE_ALL : AWAKE_NONE;
+  this->in_break_ = false;
+  this->last_activity_ = now;
+}
+
+void SDI12LoopbackPhy::send_char(char c) {
+  if (this->frame_.empty()) {
+    // the address decides who listens, before the line counts as active again
+    this->frame_started_ = micros();
+    this->frame_awake_ = this->is_awake(c, this->frame_started_);
+  }
+  this->frame_.push_back(c);
+  // the characters take their time on the line, like on the real pins
+  delayMicroseconds(SDI12_CHARACTER_US);
+  this->last_activity_ = micros();
+}
+
+void SDI12LoopbackPhy::end_frame() {
+  std::string command;
+  command.swap(this->frame_);
+  uint32_t start = this->frame_started_;
+  char address = command.empty() ? AWAKE_NONE : command[0];
+  bool awake = !command.empty() && this->frame_awake_;
+  // the others go back to standby on an address that isn't theirs, ?! reaches everybody
+  if (!awake) {
+    this->awake_ = AWAKE_NONE;
+  } else if (address != '?') {
+    this->awake_ = address;
+  }
+
+  // whatever arrived before the command doesn't belong to its response
+  this->deliver_(micros());
+  this->rx_buffer_.clear();
+  this->listening_ = true;
+  if (!awake)
+    return;
+
+  for (auto *sensor : this->sensors_) {
+    // a sensor that is still waking up from the last break misses the command
+    if (start - this->break_started_ < WAKE_BREAK_US + sensor->wake_time_us())
+      continue;
+    std::string response;
+    uint32_t latency_us = 0;
+    if (sensor->handle_command(command, response, latency_us))
+      this->transmit(response, latency_us);
+  }
+}
+
+void SDI12LoopbackPhy::transmit(const std::string &data, uint32_t delay_us) {
+  uint32_t time = micros() + delay_us;
+  for (char c : data) {
+    time += SDI12_CHARACTER_US;
+    Character character{time, static_cast<uint8_t>(c), data[0]};
+    // keep the line in time order when several transmissions are queued
+    auto it = std::upper_bound(
+        this->in_flight_.begin(), this->in_flight_.end(), character,
+        [](const Character &a, const Character &b) { return static_cast<int32_t>(a.time - b.time) < 0; });
+    this->in_flight_.insert(it, character);
+  }
+}
+
+void SDI12LoopbackPhy::cancel(char address) {
+  this->deliver_(micros());
+  this->in_flight_.erase(std::remove_if(this->in_flight_.begin(), this->in_flight_.end(),
+                                        [address](const Character &c) { return c.sender == address; }),
+                         this->in_flight_.end());
+}
+
+void SDI12LoopbackPhy::deliver_(uint32_t now) {
+  while (!this->in_flight_.empty() && static_cast<int32_t>(now - this->in_flight_.front().time) >= 0) {
+    const Character &character = this->in_flight_.front();
+    this->last_activity_ = character.time;
+    // a sensor that transmits is awake, a service request wakes it by itself
+    if (this->awake_ != AWAKE_ALL)
+      this->awake_ = character.sender;
+    if (this->listening_) {
+      if (!this->rx_buffer_.push(character.value))
+        this->overflows_++;
+      this->last_receive_ = character.time;
+    }
+    this->in_flight_.pop_front();
+  }
+}
+
+int SDI12LoopbackPhy::available() {
+  this->deliver_(micros());
+  if (this->rx_buffer_.overflowed())
+    return -1;
+  return this->rx_buffer_.size();
+}
+
+size_t SDI12LoopbackPhy::read(uint8_t *buffer, size_t length) {
+  this->deliver_(micros());
+  this->rx_buffer_.clear_overflow();
+  return this->rx_buffer_.read(buffer, length);
+}
+
+void SDI12LoopbackPhy::clear() {
+  this->deliver_(micros());
+  this->rx_buffer_.clear();
+}
+
+}  // namespace sdi12
+}  // namespace esphome
+
+#endif
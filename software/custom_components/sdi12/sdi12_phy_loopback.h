@@ -0,0 +1,110 @@
+/**
+ * @file sdi12_phy_loopback.h
+ *
+ * @brief An SDI-12 line without hardware, connecting the bus to simulated sensors.
+ *
+ * Only the ESPHome time functions are used, so the whole protocol stack above the PHY
+ * runs on the host as well as on a device without anything attached to its pins. Only
+ * built with USE_SDI12_EMULATOR, which a bus with emulated sensors defines.
+ */
+
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_SDI12_EMULATOR
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "sdi12_phy.h"
+#include "sdi12_ring_buffer.h"
+
+namespace esphome {
+namespace sdi12 {
+
+/// A sensor on a SDI12LoopbackPhy, sees every command sent while the line is awake.
+class SDI12SimulatedSensor {
+ public:
+  virtual ~SDI12SimulatedSensor() = default;
+  /**
+   * Handle @p command, including its address and the terminating '!'. Return true to
+   * answer with @p response, its first start bit @p latency_us after the end of the
+   * command (8.33 ms of marking at least, 15 ms at most per spec).
+   */
+  virtual bool handle_command(const std::string &command, std::string &response, uint32_t &latency_us) = 0;
+  /// Time the sensor needs after detecting a break before it hears a command
+  virtual uint32_t wake_time_us() const { return 0; }
+};
+
+/**
+ * The line is modelled at character level: the break and marking are checked against
+ * the wake-up timing of the spec, a command takes its 8.33 ms per character, and the
+ * characters of a response become available one by one as their stop bits end. After a
+ * command only the addressed sensor stays awake, so a command without a break only
+ * reaches the sensor that was last talked to.
+ */
+class SDI12LoopbackPhy : public SDI12Phy {
+ public:
+  void add_sensor(SDI12SimulatedSensor *sensor) { this->sensors_.push_back(sensor); }
+  /**
+   * Put @p data on the line from the sensor side, its first start bit @p delay_us from
+   * now. Used for the responses and for unsolicited service requests.
+   */
+  void transmit(const std::string &data, uint32_t delay_us = 0);
+  /// Drop what the sensor at @p address has queued but not yet sent, e.g. a service request
+  void cancel(char address);
+  /// whether a command to @p address sent now would be heard by that sensor
+  bool is_awake(char address, uint32_t now) const;
+
+  void begin() override { this->listening_ = true; }
+  void end() override { this->listening_ = false; }
+  void send_break() override;
+  void send_marking() override;
+  void send_char(char c) override;
+  void end_frame() override;
+  void listen() override { this->listening_ = true; }
+  /// the characters are passed on as bytes, the framing makes no difference
+  void set_binary(bool binary) override {}
+  int available() override;
+  size_t read(uint8_t *buffer, size_t length) override;
+  void clear() override;
+  uint32_t last_receive_time() const override { return this->last_receive_; }
+  uint32_t last_activity_time() const override { return this->last_activity_; }
+  SDI12LineCounters line_counters() const override { return {0, 0, this->overflows_}; }
+
+ protected:
+  /// A character on its way to the recorder
+  struct Character {
+    uint32_t time;  ///< micros() at the end of its stop bit
+    uint8_t value;
+    char sender;  ///< address of the transmitting sensor
+  };
+
+  /// Move the characters whose stop bit has passed to the Rx buffer
+  void deliver_(uint32_t now);
+
+  std::vector<SDI12SimulatedSensor *> sensors_;
+  std::deque<Character> in_flight_;
+  SDI12RingBuffer<uint8_t, 128> rx_buffer_;
+  uint32_t break_started_{0};
+  /// the command on its way to the sensors and when its first character started
+  std::string frame_;
+  uint32_t frame_started_{0};
+  bool frame_awake_{false};
+  /// end of the last character on the line, either direction
+  uint32_t last_activity_{0};
+  uint32_t last_receive_{0};
+  uint32_t overflows_{0};
+  bool in_break_{false};
+  static constexpr char AWAKE_NONE = '\0';
+  static constexpr char AWAKE_ALL = '*';
+  /// the sensor that is awake, AWAKE_ALL after a break, AWAKE_NONE once they sleep
+  char awake_{AWAKE_NONE};
+  bool listening_{false};
+};
+
+}  // namespace sdi12
+}  // namespace esphome
+
+#endif
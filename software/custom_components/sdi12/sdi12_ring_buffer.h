@@ -0,0 +1,123 @@
+/**
+ * @file sdi12_ring_buffer.h
+ *
+ * @brief A lock-free single-producer/single-consumer ring buffer, used to hand data from
+ * the SDI-12 interrupt service routine to the main loop.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace sdi12 {
+
+/**
+ * @brief A ring buffer for exactly one producer and one consumer.
+ *
+ * @tparam T the type of the entries
+ * @tparam N the capacity, must be a power of two
+ *
+ * The head and tail indices are free running counters that are only masked when the
+ * storage is accessed, so no modulo is needed and all @p N slots are usable.  Only the
+ * producer writes the tail and only the consumer writes the head:
+ * - the producer stores an entry and then publishes it with a release store of the tail,
+ *   the consumer reads the tail with acquire before it touches the entry.
+ * - the consumer reads an entry and then frees the slot with a release store of the head,
+ *   the producer reads the head with acquire before it overwrites the slot.
+ *
+ * As only plain atomic loads and stores are used, this also works on cores without
+ * atomic read-modify-write instructions.
+ */
+template<typename T, size_t N> class SDI12RingBuffer {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SDI12RingBuffer capacity must be a power of two");
+
+ public:
+  /// The number of entries the buffer holds
+  static constexpr size_t capacity() { return N; }
+
+  /**
+   * @brief Append an entry, producer side
+   *
+   * @return false, and the overflow flag set, if the buffer was full
+   */
+  bool push(const T &value) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == N) {
+      overflow_.store(true, std::memory_order_relaxed);
+      return false;
+    }
+    buffer_[tail & MASK] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest entry, consumer side
+   *
+   * @return false if the buffer was empty
+   */
+  bool pop(T &value) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+    value = buffer_[head & MASK];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Look at the oldest entry without removing it, consumer side
+   *
+   * @return false if the buffer was empty
+   */
+  bool peek(T &value) const {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+    value = buffer_[head & MASK];
+    return true;
+  }
+
+  /**
+   * @brief Remove up to @p length entries at once, consumer side
+   *
+   * @return the number of entries copied to @p out
+   */
+  size_t read(T *out, size_t length) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t count = tail_.load(std::memory_order_acquire) - head;
+    if (count > length)
+      count = length;
+    for (uint32_t i = 0; i < count; i++)
+      out[i] = buffer_[(head + i) & MASK];
+    head_.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  /// The number of entries waiting, consumer side
+  size_t size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_relaxed); }
+
+  /// Drop all waiting entries and the overflow flag, consumer side
+  void clear() {
+    head_.store(tail_.load(std::memory_order_acquire), std::memory_order_release);
+    overflow_.store(false, std::memory_order_relaxed);
+  }
+
+  /// Whether an entry was dropped because the buffer was full
+  bool overflowed() const { return overflow_.load(std::memory_order_relaxed); }
+  void clear_overflow() { overflow_.store(false, std::memory_order_relaxed); }
+
+ protected:
+  static constexpr uint32_t MASK = N - 1;
+
+  T buffer_[N];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<bool> overflow_{false};
+};
+
+}  // namespace sdi12
+}  // namespace esphome
@@ -0,0 +1,91 @@
+#include "sdi12_sensor.h"
+
+#ifdef USE_SENSOR
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace sdi12 {
+
+static const char *const TAG = "sdi12.sensor";
+
+static const char *command_to_string(SDI12SensorCommand command) {
+  switch (command) {
+    case SDI12SensorCommand::MEASURE:
+      return "M";
+    case SDI12SensorCommand::CONCURRENT:
+      return "C";
+    case SDI12SensorCommand::CONTINUOUS:
+      return "R";
+    default:
+      return "?";
+  }
+}
+
+void SDI12SensorComponent::update() {
+  if (this->command_type_ == SDI12SensorCommand::CONTINUOUS) {
+    this->read_continuous_(this->command_index_, [this](SDI12Status status, std::string_view response) {
+      float values[SDI12_MAX_VALUES];
+      SDI12ValidValues valid;
+      size_t count = 0;
+      if (status == SDI12Status::OK && (response.empty() || response[0] != this->address_)) {
+        ESP_LOGW(TAG, "Invalid data response from SDI-12 device %c: '%.*s'", this->address_,
+                 static_cast<int>(response.length()), response.data());
+        status = SDI12Status::INVALID_RESPONSE;
+      }
+      if (status == SDI12Status::OK) {
+        SDI12ParseResult result = sdi12_parse_values(response.substr(1), values, SDI12_MAX_VALUES);
+        count = result.count;
+        for (size_t i = 0; i < count; i++)
+          valid[i] = result.is_valid(i);
+      }
+      this->publish_(status, values, count, valid);
+    }, this->phase_offset_);
+    return;
+  }
+
+  MeasurementType type = this->command_type_ == SDI12SensorCommand::CONCURRENT ? MeasurementType::CONCURRENT
+                                                                                  : MeasurementType::MEASURE;
+  this->start_measurement_(type, [this](SDI12Status status, const float *values, size_t count,
+                                        const SDI12ValidValues &valid) {
+    this->publish_(status, values, count, valid);
+  }, this->phase_offset_, this->command_index_);
+}
+
+void SDI12SensorComponent::publish_(SDI12Status status, const float *values, size_t count,
+                                    const SDI12ValidValues &valid) {
+  if (status != SDI12Status::OK) {
+    ESP_LOGW(TAG, "Measurement of SDI-12 device %c failed: %s", this->address_, sdi12_status_to_string(status));
+    return;
+  }
+  ESP_LOGV(TAG, "SDI-12 device %c returned %u values", this->address_, static_cast<unsigned>(count));
+
+  // a value the sensor didn't send, or that isn't a number, keeps the previous state
+  for (const auto &value : this->values_to_publish_) {
+    if (value.index >= count || !valid[value.index]) {
+      ESP_LOGD(TAG, "SDI-12 device %c returned no valid value %u", this->address_, value.index);
+      continue;
+    }
+    value.sensor->publish_state(values[value.index] * value.multiply + value.offset);
+  }
+}
+
+void SDI12SensorComponent::dump_config() {
+  ESP_LOGCONFIG(TAG, "SDI-12 Sensor:");
+  LOG_SDI12_DEVICE(this);
+  // aM! and aC! go without an index, aR0! always has one
+  bool numbered = this->command_index_ > 0 || this->command_type_ == SDI12SensorCommand::CONTINUOUS;
+  char index[2] = {numbered ? static_cast<char>('0' + this->command_index_) : '\0', '\0'};
+  ESP_LOGCONFIG(TAG, "  Command: %c%s%s%s!", this->address_, command_to_string(this->command_type_),
+                this->crc_ ? "C" : "", index);
+  LOG_UPDATE_INTERVAL(this);
+  for (const auto &value : this->values_to_publish_) {
+    LOG_SENSOR("  ", "Value", value.sensor);
+    ESP_LOGCONFIG(TAG, "    Index: %u, Multiply: %g, Offset: %g", value.index, value.multiply, value.offset);
+  }
+}
+
+}  // namespace sdi12
+}  // namespace esphome
+
+#endif
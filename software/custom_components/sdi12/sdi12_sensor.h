@@ -0,0 +1,61 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_SENSOR
+
+#include "esphome/core/component.h"
+#include "esphome/components/sensor/sensor.h"
+#include "sdi12.h"
+
+namespace esphome {
+namespace sdi12 {
+
+/// The command a generic sensor reads its values with.
+enum class SDI12SensorCommand : uint8_t {
+  MEASURE = 0,  ///< aM!, aM1! ... aM9!
+  CONCURRENT,   ///< aC!, aC1! ... aC9!
+  CONTINUOUS,   ///< aR0! ... aR9!
+};
+
+/// One value of the measurement published to a sensor, scaled as value * multiply + offset.
+struct SDI12SensorValue {
+  uint8_t index;
+  float multiply;
+  float offset;
+  sensor::Sensor *sensor;
+};
+
+/**
+ * @brief An SDI-12 sensor described entirely in YAML
+ *
+ * The command, the values to publish and their scaling are set up by the code generator,
+ * the measurement runs through the same engine as the dedicated drivers: scheduled,
+ * non-blocking, all data pages collected, CRC-checked if requested.
+ */
+class SDI12SensorComponent : public PollingComponent, public SDI12Device {
+ public:
+  void set_command(SDI12SensorCommand command, uint8_t index) {
+    this->command_type_ = command;
+    this->command_index_ = index;
+  }
+  void add_value(uint8_t index, float multiply, float offset, sensor::Sensor *sensor) {
+    this->values_to_publish_.push_back({index, multiply, offset, sensor});
+  }
+
+  float get_setup_priority() const override { return setup_priority::DATA; }
+  void dump_config() override;
+  void update() override;
+
+ protected:
+  void publish_(SDI12Status status, const float *values, size_t count, const SDI12ValidValues &valid);
+
+  SDI12SensorCommand command_type_{SDI12SensorCommand::CONCURRENT};
+  uint8_t command_index_{0};
+  std::vector<SDI12SensorValue> values_to_publish_;
+};
+
+}  // namespace sdi12
+}  // namespace esphome
+
+#endif
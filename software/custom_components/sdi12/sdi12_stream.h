@@ -0,0 +1,86 @@
+/**
+ * @file sdi12_stream.h
+ *
+ * @brief The samples of a continuous measurement (aRn!), read over and over by
+ * SDI12Device::start_streaming_(), and their aggregates over a time window.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace sdi12 {
+
+/// Mean, minimum and maximum of one value over the samples of a window.
+struct SDI12Aggregate {
+  float mean;
+  float min;
+  float max;
+  /// samples the aggregate is based on, the other fields are NAN if there were none
+  uint32_t count;
+};
+
+/**
+ * @brief The most recent samples of a stream, in a fixed ring that overwrites the oldest
+ *
+ * @tparam N the number of samples kept
+ * @tparam VALUES the number of values per sample
+ *
+ * Samples are added and aggregated from the main loop only.  A window longer than the
+ * samples in the ring covers all of them.
+ */
+template<size_t N, size_t VALUES> class SDI12SampleRing {
+ public:
+  /// Add a sample taken at millis() @p time, values that aren't NAN count for the aggregates
+  void push(uint32_t time, const float (&values)[VALUES]) {
+    Sample &sample = this->samples_[this->next_];
+    sample.time = time;
+    for (size_t i = 0; i < VALUES; i++)
+      sample.values[i] = values[i];
+    this->next_ = (this->next_ + 1) % N;
+    if (this->size_ < N)
+      this->size_++;
+  }
+
+  /// Aggregate value @p index over the samples of the last @p window_ms before @p now
+  SDI12Aggregate aggregate(size_t index, uint32_t window_ms, uint32_t now) const {
+    SDI12Aggregate result{NAN, NAN, NAN, 0};
+    float sum = 0;
+    for (size_t i = 0; i < this->size_; i++) {
+      // newest first, so the loop can end at the first sample outside the window
+      const Sample &sample = this->samples_[(this->next_ + N - 1 - i) % N];
+      if (now - sample.time > window_ms)
+        break;
+      float value = sample.values[index];
+      if (std::isnan(value))
+        continue;
+      if (result.count == 0 || value < result.min)
+        result.min = value;
+      if (result.count == 0 || value > result.max)
+        result.max = value;
+      sum += value;
+      result.count++;
+    }
+    if (result.count > 0)
+      result.mean = sum / result.count;
+    return result;
+  }
+
+  size_t size() const { return this->size_; }
+  void clear() { this->size_ = 0; }
+
+ protected:
+  struct Sample {
+    uint32_t time;
+    float values[VALUES];
+  };
+  Sample samples_[N]{};
+  size_t next_{0};
+  size_t size_{0};
+};
+
+}  // namespace sdi12
+}  // namespace esphome
@@ -0,0 +1,83 @@
+/**
+ * @file sdi12_values.h
+ *
+ * @brief The values of SDI-12 data responses (aDn!, aRn!), parsed in a single pass
+ * without allocating.
+ *
+ * Every value starts with its sign, followed by up to seven digits and an optional
+ * decimal point, e.g. "+1.23-4.5+6".  The response ends with <CR><LF>, any CRC has
+ * already been removed by the bus.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace esphome {
+namespace sdi12 {
+
+/// The outcome of sdi12_parse_values()
+struct SDI12ParseResult {
+  /// values found, each of them was written to the output
+  size_t count{0};
+  /**
+   * bit i is set if value i is a number, it is NAN otherwise. A response holds at most
+   * 75 characters, 37 values of two, so 64 bits cover all of them.
+   */
+  uint64_t valid{0};
+
+  bool is_valid(size_t index) const { return index < this->count && (this->valid >> index) & 1; }
+  /// whether the response had @p expected values and all of them are numbers
+  bool all_valid(size_t expected) const {
+    return this->count == expected && this->valid == (expected >= 64 ? ~0ULL : (1ULL << expected) - 1);
+  }
+};
+
+/**
+ * Parse the values in @p text, the response after its address, into @p values, at most
+ * @p capacity of them. Parsing stops at the <CR><LF> or the end of @p text.
+ */
+inline SDI12ParseResult sdi12_parse_values(std::string_view text, float *values, size_t capacity) {
+  static const float POWERS_OF_TEN[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f};
+  SDI12ParseResult result;
+  size_t pos = 0;
+  while (result.count < capacity && pos < text.length() && (text[pos] == '+' || text[pos] == '-')) {
+    bool negative = text[pos++] == '-';
+    uint32_t mantissa = 0;
+    uint8_t digits = 0;
+    uint8_t decimals = 0;
+    bool point = false;
+    bool valid = true;
+    // a value ends at the sign of the next one or the end of the response
+    for (; pos < text.length(); pos++) {
+      char c = text[pos];
+      if (c == '+' || c == '-' || c == '\r' || c == '\n')
+        break;
+      if (c >= '0' && c <= '9' && digits < 9) {
+        mantissa = mantissa * 10 + (c - '0');
+        digits++;
+        if (point)
+          decimals++;
+      } else if (c == '.' && !point) {
+        point = true;
+      } else {
+        valid = false;
+      }
+    }
+    valid = valid && digits > 0;
+    // With the seven digits of the spec the mantissa and the power of ten are exact, so
+    // the division rounds only once
+    float value = valid ? static_cast<float>(mantissa) / POWERS_OF_TEN[decimals] : NAN;
+    values[result.count] = negative ? -value : value;
+    if (valid && result.count < 64)
+      result.valid |= 1ULL << result.count;
+    result.count++;
+  }
+  return result;
+}
+
+}  // namespace sdi12
+}  // namespace esphome
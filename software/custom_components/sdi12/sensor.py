@@ -0,0 +1,111 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.const import (
+    CONF_ID,
+    CONF_INDEX,
+    CONF_MULTIPLY,
+    CONF_OFFSET,
+    STATE_CLASS_MEASUREMENT,
+)
+from . import (
+    CONF_CRC,
+    SDI12Device,
+    register_sdi12_device,
+    sdi12_device_schema,
+    sdi12_ns,
+)
+
+DEPENDENCIES = ["sdi12"]
+
+CONF_COMMAND = "command"
+CONF_VALUES = "values"
+
+SDI12SensorComponent = sdi12_ns.class_(
+    "SDI12SensorComponent", cg.PollingComponent, SDI12Device
+)
+SDI12SensorCommand = sdi12_ns.enum("SDI12SensorCommand", is_class=True)
+
+# command: (the command of the engine, whether it requests a CRC)
+COMMANDS = {
+    "M": (SDI12SensorCommand.MEASURE, False),
+    "MC": (SDI12SensorCommand.MEASURE, True),
+    "C": (SDI12SensorCommand.CONCURRENT, False),
+    "CC": (SDI12SensorCommand.CONCURRENT, True),
+    "R": (SDI12SensorCommand.CONTINUOUS, False),
+    "RC": (SDI12SensorCommand.CONTINUOUS, True),
+}
+
+# values an aM! measurement returns at most, aC! and aR! take up to 99
+MAX_MEASURE_VALUES = 9
+
+VALUE_SCHEMA = sensor.sensor_schema(
+    accuracy_decimals=2,
+    state_class=STATE_CLASS_MEASUREMENT,
+).extend(
+    {
+        cv.Required(CONF_INDEX): cv.int_range(min=0, max=98),
+        cv.Optional(CONF_MULTIPLY, default=1.0): cv.float_,
+        cv.Optional(CONF_OFFSET, default=0.0): cv.float_,
+    }
+)
+
+
+def validate_values(config):
+    if config[CONF_COMMAND].startswith("M"):
+        for value in config[CONF_VALUES]:
+            if value[CONF_INDEX] >= MAX_MEASURE_VALUES:
+                raise cv.Invalid(
+                    f"aM! returns at most {MAX_MEASURE_VALUES} values, index {value[CONF_INDEX]} is out of range, "
+                    "use command C for more"
+                )
+    return config
+
+
+def validate_crc(config):
+    # MC, CC and RC request a CRC by themselves, crc: true adds it to M, C and R
+    command = config[CONF_COMMAND]
+    with_crc = COMMANDS[command][1]
+    if CONF_CRC not in config:
+        config[CONF_CRC] = with_crc
+    elif with_crc and not config[CONF_CRC]:
+        raise cv.Invalid(f"command {command} requests a CRC, remove crc: false", [CONF_CRC])
+    elif config[CONF_CRC] and not with_crc:
+        config[CONF_COMMAND] = command + "C"
+    return config
+
+
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(SDI12SensorComponent),
+            cv.Optional(CONF_COMMAND, default="C"): cv.one_of(*COMMANDS, upper=True),
+            cv.Optional(CONF_INDEX, default=0): cv.int_range(min=0, max=9),
+            cv.Required(CONF_VALUES): cv.All(cv.ensure_list(VALUE_SCHEMA), cv.Length(min=1)),
+        }
+    )
+    .extend(cv.polling_component_schema("60s"))
+    .extend(sdi12_device_schema(None))
+    .extend(
+        {
+            # without a default, the command decides unless crc is given
+            cv.Optional(CONF_CRC): cv.boolean,
+        }
+    ),
+    validate_values,
+    validate_crc,
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    await register_sdi12_device(var, config)
+
+    # the CRC was set with the device, validate_crc made it agree with the command
+    command, _ = COMMANDS[config[CONF_COMMAND]]
+    cg.add(var.set_command(command, config[CONF_INDEX]))
+
+    for conf in config[CONF_VALUES]:
+        sens = await sensor.new_sensor(conf)
+        cg.add(var.add_value(conf[CONF_INDEX], conf[CONF_MULTIPLY], conf[CONF_OFFSET], sens))
@@ -0,0 +1,350 @@
+// Benchmark of the hot paths of the SDI-12 component: the parity of a character, the Rx
+// ring buffer, the CRC and the value parser of a data page (and the istringstream parser
+// it replaced, for comparison), the edge decoder, the Rx interrupt with inline and
+// deferred decoding, and whole aM!/aD0! measurements on the virtual clock. It prints
+// ns/op and allocs/op and compares them with a baseline:
+//
+//   bench_sdi12                              print the results
+//   bench_sdi12 --baseline FILE              fail on more allocs/op than in FILE
+//   bench_sdi12 --baseline FILE --timing     fail on slower ns/op than in FILE too
+//   bench_sdi12 --baseline FILE --update     write the results to FILE
+//   bench_sdi12 ... --tolerance 4            allowed factor on ns/op, 3 by default
+//
+// allocs/op may never grow. ns/op vary with the machine and its load, they are compared
+// only with --timing (SDI12_BENCH_STRICT in CMake), with the tolerance.
+// Each benchmark also checks that it still does its work, e.g. all characters received.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "sdi12_alloc_counter.h"
+#include "sdi12_scripted_phy.h"
+#include "sdi12_test.h"
+#include "sdi12/sdi12_bus.h"
+#include "sdi12/sdi12_crc.h"
+#include "sdi12/sdi12_decoder.h"
+#include "sdi12/sdi12_ring_buffer.h"
+#include "sdi12/sdi12_values.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+static const uint8_t RX_PIN = 4;
+static const uint8_t TX_PIN = 5;
+static const uint8_t OE_PIN = 6;
+// a data page of ten values, as it comes from the line
+static const char PAGE[] = "0+21.5-0.125+1013.25+0.0+99.9-40.0+3.14159+7+65.3-12.75\r\n";
+// runs of a benchmark are timed in batches of at least this long, the fastest batch counts:
+// whatever else the machine does can only slow a batch down
+static const auto BATCH_DURATION = std::chrono::milliseconds(2);
+static const int BATCHES = 25;
+
+// results the compiler has to compute
+static volatile uint32_t sink;
+
+struct Result {
+  double ns_per_op;
+  double allocs_per_op;
+};
+
+// Time @p run, which does @p ops operations, after a first run that may set things up
+template<typename Run> static Result measure(size_t ops, Run run) {
+  run();
+  size_t before = allocations();
+  run();
+  double allocs = static_cast<double>(allocations() - before) / ops;
+
+  double best = 0.0;
+  for (int batch = 0; batch < BATCHES; batch++) {
+    size_t runs = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration elapsed;
+    do {
+      run();
+      runs++;
+      elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed < BATCH_DURATION);
+    double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / static_cast<double>(runs * ops);
+    if (batch == 0 || ns < best)
+      best = ns;
+  }
+  return {best, allocs};
+}
+
+// The Rx edges of @p text as 7E1 characters back to back: the time since the previous
+// edge and the level of the Rx pin after it (HIGH is marking)
+static std::vector<std::pair<uint32_t, uint8_t>> edges_of(const char *text) {
+  std::vector<std::pair<uint32_t, uint8_t>> edges;
+  uint8_t level = 1;
+  uint64_t last = 0;
+  for (size_t i = 0; text[i] != '\0'; i++) {
+    uint8_t c = static_cast<uint8_t>(text[i]) & 0x7F;
+    uint16_t bits = c << 1 | __builtin_parity(c) << 8 | 1 << 9;
+    uint64_t start = 10000 + i * SDI12_CHARACTER_US;
+    for (uint8_t bit = 0; bit < 10; bit++) {
+      uint8_t next = (bits >> bit) & 1;
+      if (next == level)
+        continue;
+      uint64_t time = start + sdi12_bits_to_micros(bit);
+      edges.emplace_back(static_cast<uint32_t>(time - last), next);
+      last = time;
+      level = next;
+    }
+  }
+  return edges;
+}
+
+static Result bench_parity() {
+  return measure(256, [] {
+    uint32_t parity = 0;
+    for (uint32_t v = 0; v < 256; v++)
+      parity += SDI12::parity_even_bit(v);
+    sink = parity;
+  });
+}
+
+// a push and a pop
+static Result bench_ring_buffer() {
+  static SDI12RingBuffer<uint8_t, 64> buffer;
+  return measure(64, [] {
+    uint8_t c = 0;
+    for (size_t i = 0; i < 64; i++)
+      buffer.push(static_cast<uint8_t>(i));
+    uint32_t sum = 0;
+    while (buffer.pop(c))
+      sum += c;
+    sink = sum;
+  });
+}
+
+// the CRC of a data page
+static Result bench_crc() {
+  return measure(1, [] { sink = sdi12_crc16(PAGE, sizeof(PAGE) - 3); });
+}
+
+// the values of a data page
+static Result bench_parse() {
+  Result result = measure(1, [] {
+    float values[16];
+    sink = sdi12_parse_values(std::string_view(PAGE + 1), values, 16).count;
+  });
+  SDI12_CHECK_EQ(sink, 10u);
+  return result;
+}
+
+// The parser the values had before sdi12_parse_values(): a substring and an istringstream
+// per value. Kept to compare against, see parse_values_istringstream in the baseline.
+static size_t parse_values_istringstream(const std::string &response, float *values, size_t capacity) {
+  size_t start = 0;
+  size_t index = 0;
+  while (start < response.length() && index < capacity) {
+    size_t end = response.find_first_of("+-", start + 1);
+    if (end == std::string::npos || index == capacity - 1)
+      end = response.length();
+    std::string token = response.substr(start, end - start);
+    if (index == capacity - 1) {
+      size_t last = token.find_last_not_of("\r\n");
+      if (last != std::string::npos)
+        token.erase(last + 1);
+    }
+    std::istringstream converter(token);
+    converter >> values[index];
+    if (converter.fail())
+      values[index] = NAN;
+    start = end;
+    index++;
+  }
+  return index;
+}
+
+// the values of a data page with the former parser, which knew how many to expect
+static Result bench_parse_istringstream() {
+  static const std::string page(PAGE + 1);
+  Result result = measure(1, [] {
+    float values[10];
+    sink = parse_values_istringstream(page, values, 10);
+  });
+  SDI12_CHECK_EQ(sink, 10u);
+  return result;
+}
+
+// per edge
+static Result bench_decoder() {
+  static const auto edges = edges_of(PAGE);
+  static SDI12EdgeDecoder decoder;
+  Result result = measure(edges.size(), [] {
+    uint32_t time = 0;
+    uint32_t received = 0;
+    uint8_t c;
+    for (const auto &edge : edges) {
+      time += edge.first;
+      received += decoder.feed(time, edge.second, c);
+    }
+    received += decoder.flush(time + SDI12_CHARACTER_US, c);
+    sink = received;
+  });
+  SDI12_CHECK_EQ(sink, sizeof(PAGE) - 1);
+  return result;
+}
+
+// per edge, through the pin interrupt of the host HAL, plus reading the characters; the
+// main loop takes them every character, which decodes the edges if deferred
+static Result bench_rx_interrupt(bool deferred) {
+  static const auto edges = edges_of(PAGE);
+  static SDI12HostHal hal;
+  set_sdi12_host_hal(&hal);
+  static SDI12 sdi12;
+  sdi12.setDataPin(RX_PIN, TX_PIN, OE_PIN);
+  sdi12.setDeferredDecoding(deferred);
+  sdi12.begin();
+  sdi12.forceListen();
+  Result result = measure(edges.size(), [] {
+    uint8_t buffer[64];
+    size_t received = 0;
+    uint32_t since_read = 0;
+    for (const auto &edge : edges) {
+      since_read += edge.first;
+      if (since_read >= SDI12_CHARACTER_US) {
+        received += sdi12.read(buffer, sizeof(buffer));
+        since_read = edge.first;
+      }
+      hal.advance(edge.first);
+      hal.set_input(RX_PIN, edge.second);
+    }
+    hal.advance(SDI12_CHARACTER_US);
+    sink = received + sdi12.read(buffer, sizeof(buffer));
+  });
+  // every character made it, and only once
+  SDI12_CHECK_EQ(sink, sizeof(PAGE) - 1);
+  return result;
+}
+
+// aM! and aD0! with nine values, on a line that answers without allocating
+static Result bench_measurement() {
+  static const std::vector<ScriptedPhy::Answer> answers = {
+      {"0M!", "00009\r\n"},
+      {"0D0!", PAGE},
+  };
+  static SDI12HostHal hal;
+  set_sdi12_host_hal(&hal);
+  static ScriptedPhy phy(answers);
+  static SDI12Bus bus;
+  bus.set_phy(&phy);
+  bus.set_wake_time(0);
+  static TestDevice device;
+  device.set_sdi12_address("0");
+  device.set_sdi12_bus(&bus);
+  bus.setup();
+  Result result = measure(1, [] {
+    bool done = false;
+    device.start_measurement_(MeasurementType::MEASURE, [&done](SDI12Status status, const float *, size_t count,
+                                                                const SDI12ValidValues &valid) {
+      done = true;
+      sink = status == SDI12Status::OK ? valid.count() : 0;
+    });
+    esphome::Component *loop = &bus;
+    run_until({loop}, [&done] { return done; }, 1000000, 500);
+  });
+  SDI12_CHECK_EQ(sink, 9u);
+  return result;
+}
+
+// name, ns/op, allocs/op of each benchmark in @p path
+static std::map<std::string, Result> read_baseline(const std::string &path) {
+  std::map<std::string, Result> baseline;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::istringstream fields(line);
+    std::string name;
+    Result result;
+    if (fields >> name >> result.ns_per_op >> result.allocs_per_op)
+      baseline[name] = result;
+  }
+  return baseline;
+}
+
+static bool write_baseline(const std::string &path, const std::vector<std::pair<std::string, Result>> &results) {
+  FILE *file = std::fopen(path.c_str(), "w");
+  if (file == nullptr)
+    return false;
+  std::fprintf(file, "# bench_sdi12 results to compare against: name, ns/op, allocs/op\n");
+  std::fprintf(file, "# regenerate with: bench_sdi12 --baseline <this file> --update\n");
+  for (const auto &result : results)
+    std::fprintf(file, "%s %.2f %.2f\n", result.first.c_str(), result.second.ns_per_op, result.second.allocs_per_op);
+  return std::fclose(file) == 0;
+}
+
+int main(int argc, char **argv) {
+  std::string baseline_path;
+  bool update = false;
+  bool timing = false;
+  double tolerance = 3.0;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baseline_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--update") == 0) {
+      update = true;
+    } else if (std::strcmp(argv[i], "--timing") == 0) {
+      timing = true;
+    } else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      tolerance = std::atof(argv[++i]);
+    } else {
+      std::fprintf(stderr, "usage: %s [--baseline FILE [--update | --timing]] [--tolerance FACTOR]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<std::pair<std::string, Result>> results = {
+      {"parity", bench_parity()},
+      {"ring_buffer", bench_ring_buffer()},
+      {"crc", bench_crc()},
+      {"parse_values", bench_parse()},
+      {"parse_values_istringstream", bench_parse_istringstream()},
+      {"decoder", bench_decoder()},
+      {"rx_interrupt", bench_rx_interrupt(false)},
+      {"rx_interrupt_deferred", bench_rx_interrupt(true)},
+      {"measurement", bench_measurement()},
+  };
+
+  if (update) {
+    if (baseline_path.empty() || !write_baseline(baseline_path, results)) {
+      std::fprintf(stderr, "can't write the baseline '%s'\n", baseline_path.c_str());
+      return 1;
+    }
+  }
+  std::map<std::string, Result> baseline;
+  if (!baseline_path.empty() && !update)
+    baseline = read_baseline(baseline_path);
+
+  int regressions = 0;
+  std::printf("%-28s %12s %10s %12s %10s\n", "benchmark", "ns/op", "allocs/op", "baseline", "allocs");
+  for (const auto &result : results) {
+    const Result &now = result.second;
+    auto it = baseline.find(result.first);
+    if (it == baseline.end()) {
+      std::printf("%-28s %12.2f %10.2f\n", result.first.c_str(), now.ns_per_op, now.allocs_per_op);
+      continue;
+    }
+    const Result &base = it->second;
+    bool slower = timing && now.ns_per_op > base.ns_per_op * tolerance;
+    bool allocates = now.allocs_per_op > base.allocs_per_op + 0.005;
+    std::printf("%-28s %12.2f %10.2f %12.2f %10.2f%s%s\n", result.first.c_str(), now.ns_per_op, now.allocs_per_op,
+                base.ns_per_op, base.allocs_per_op, slower ? "  SLOWER" : "", allocates ? "  MORE ALLOCATIONS" : "");
+    regressions += slower || allocates;
+  }
+  if (regressions > 0) {
+    std::fprintf(stderr, "bench_sdi12: %d regressions against %s\n", regressions, baseline_path.c_str());
+    return 1;
+  }
+  // a benchmark that stopped doing its work
+  return failures() > 0 ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "sdi12_alloc_counter.h"
+
+static std::atomic<size_t> allocation_count{0};
+
+void *operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size != 0 ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) { return ::operator new(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace esphome {
+namespace sdi12 {
+namespace testing {
+
+size_t allocations() { return allocation_count.load(std::memory_order_relaxed); }
+
+}  // namespace testing
+}  // namespace sdi12
+}  // namespace esphome
@@ -0,0 +1,23 @@
+/**
+ * @file sdi12_alloc_counter.h
+ *
+ * @brief Counts the heap allocations of a test, link sdi12_alloc_counter.cpp into it.
+ *
+ * The global operator new is replaced for the whole executable, so anything in between
+ * two reads of sdi12_allocations() that touched the heap shows up.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace esphome {
+namespace sdi12 {
+namespace testing {
+
+/// Calls of operator new since the start of the program
+size_t allocations();
+
+}  // namespace testing
+}  // namespace sdi12
+}  // namespace esphome
@@ -0,0 +1,91 @@
+/**
+ * @file sdi12_scripted_phy.h
+ *
+ * @brief A line that answers from a fixed table, for the host tests and the benchmark.
+ *
+ * It doesn't allocate once constructed, so whatever the heap sees while it runs comes from
+ * the bus and the devices above it.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "sdi12/sdi12_host.h"
+#include "sdi12/sdi12_phy.h"
+
+namespace esphome {
+namespace sdi12 {
+namespace testing {
+
+/// The response to a command becomes available character by character, 9 ms after the command
+class ScriptedPhy : public SDI12Phy {
+ public:
+  struct Answer {
+    const char *command;
+    std::string response;
+  };
+  explicit ScriptedPhy(const std::vector<Answer> &answers) : answers_(answers) {}
+
+  void begin() override {}
+  void end() override {}
+  void send_break() override {}
+  void send_marking() override {}
+  void send_char(char c) override {
+    delayMicroseconds(SDI12_CHARACTER_US);
+    if (this->frame_length_ < sizeof(this->frame_))
+      this->frame_[this->frame_length_++] = c;
+  }
+  void end_frame() override {
+    this->last_activity_ = micros();
+    this->response_ = nullptr;
+    for (const auto &answer : this->answers_) {
+      if (std::strlen(answer.command) == this->frame_length_ &&
+          std::memcmp(answer.command, this->frame_, this->frame_length_) == 0) {
+        this->response_ = &answer.response;
+        this->start_ = this->last_activity_ + 9000;
+        this->read_ = 0;
+      }
+    }
+    this->frame_length_ = 0;
+  }
+  void listen() override {}
+  void set_binary(bool binary) override {}
+  int available() override { return this->arrived_() - this->read_; }
+  size_t read(uint8_t *buffer, size_t length) override {
+    size_t count = std::min<size_t>(length, this->arrived_() - this->read_);
+    std::memcpy(buffer, this->response_->data() + this->read_, count);
+    this->read_ += count;
+    return count;
+  }
+  void clear() override { this->read_ = this->arrived_(); }
+  uint32_t last_receive_time() const override { return this->start_ + this->read_ * SDI12_CHARACTER_US; }
+  uint32_t last_activity_time() const override { return this->last_activity_; }
+  SDI12LineCounters line_counters() const override { return {0, 0, 0}; }
+
+ protected:
+  size_t arrived_() {
+    if (this->response_ == nullptr)
+      return 0;
+    int32_t elapsed = micros() - this->start_;
+    if (elapsed < 0)
+      return 0;
+    this->last_activity_ = micros();
+    return std::min<size_t>(elapsed / SDI12_CHARACTER_US, this->response_->size());
+  }
+
+  const std::vector<Answer> &answers_;
+  const std::string *response_{nullptr};
+  uint32_t start_{0};
+  size_t read_{0};
+  uint32_t last_activity_{0};
+  /// the command being sent
+  char frame_[16];
+  size_t frame_length_{0};
+};
+
+}  // namespace testing
+}  // namespace sdi12
+}  // namespace esphome
@@ -0,0 +1,118 @@
+/**
+ * @file sdi12_test.h
+ *
+ * @brief Checks and helpers shared by the host tests of the SDI-12 component.
+ *
+ * A test is a plain executable: the checks print what failed and count it, and main()
+ * returns sdi12_test_result() so ctest sees the outcome.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+#include "esphome/core/component.h"
+#include "sdi12/sdi12.h"
+#include "sdi12/sdi12_host.h"
+
+namespace esphome {
+namespace sdi12 {
+namespace testing {
+
+inline int &failures() {
+  static int failures = 0;
+  return failures;
+}
+
+template<typename A, typename B>
+void check_equal(const A &actual, const B &expected, const char *actual_text, const char *expected_text,
+                 const char *file, int line) {
+  if (actual == expected)
+    return;
+  std::ostringstream message;
+  message << file << ":" << line << ": " << actual_text << " == " << expected_text << " failed, " << actual
+          << " != " << expected;
+  std::fprintf(stderr, "%s\n", message.str().c_str());
+  failures()++;
+}
+
+/// Print the outcome of the test @p name, the exit code for main()
+inline int result(const char *name) {
+  if (failures() > 0) {
+    std::fprintf(stderr, "%s: %d checks failed\n", name, failures());
+    return 1;
+  }
+  std::printf("%s: passed\n", name);
+  return 0;
+}
+
+/// A pin of the virtual board, only its number matters
+class TestPin : public InternalGPIOPin {
+ public:
+  explicit TestPin(uint8_t pin) : pin_(pin) {}
+  uint8_t get_pin() const override { return this->pin_; }
+
+ protected:
+  uint8_t pin_;
+};
+
+/// A device that hands its protected API to the test
+class TestDevice : public SDI12Device {
+ public:
+  using SDI12Device::command_;
+  using SDI12Device::read_continuous_;
+  using SDI12Device::send_command_;
+  using SDI12Device::start_binary_measurement_;
+  using SDI12Device::start_measurement_;
+  using SDI12Device::start_streaming_;
+  using SDI12Device::stop_streaming_;
+  char get_address() const { return this->address_; }
+};
+
+/// Run the loop of @p components on the virtual clock, @p step_us at a time, for @p duration_us
+inline void run_for(std::initializer_list<Component *> components, uint64_t duration_us, uint32_t step_us = 200) {
+  SDI12HostHal &hal = sdi12_host_hal();
+  uint64_t until = hal.now_us() + duration_us;
+  while (hal.now_us() < until) {
+    for (auto *component : components)
+      component->loop();
+    hal.advance(step_us);
+  }
+}
+
+/// Run like run_for() until @p done returns true, false if it didn't within @p timeout_us
+template<typename Done>
+bool run_until(std::initializer_list<Component *> components, Done done, uint64_t timeout_us,
+               uint32_t step_us = 200) {
+  SDI12HostHal &hal = sdi12_host_hal();
+  uint64_t until = hal.now_us() + timeout_us;
+  while (!done()) {
+    if (hal.now_us() >= until)
+      return false;
+    for (auto *component : components)
+      component->loop();
+    hal.advance(step_us);
+  }
+  return true;
+}
+
+}  // namespace testing
+}  // namespace sdi12
+}  // namespace esphome
+
+#define SDI12_CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      ::esphome::sdi12::testing::failures()++; \
+    } \
+  } while (0)
+
+#define SDI12_CHECK_EQ(actual, expected) \
+  ::esphome::sdi12::testing::check_equal((actual), (expected), #actual, #expected, __FILE__, __LINE__)
+
+#define SDI12_CHECK_NEAR(actual, expected, tolerance) \
+  SDI12_CHECK(std::fabs(static_cast<double>(actual) - static_cast<double>(expected)) <= (tolerance))
@@ -0,0 +1,241 @@
+/**
+ * @file sdi12_test_board.h
+ *
+ * @brief A virtual board with SDI-12 sensors wired to its pins, for the host tests.
+ *
+ * The recorder under test bit-bangs its commands on the Tx pin of a line as it would on
+ * a device. The board samples them at the bit centres like a sensor, hands each complete
+ * command to the responder of the line, and plays the answer back on the Rx pin edge by
+ * edge, each at its exact time on the virtual clock. Skew and jitter can be added to the
+ * edges to test the receiver against a sensor with a poor clock.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "sdi12/sdi12_decoder.h"
+#include "sdi12/sdi12_host.h"
+
+namespace esphome {
+namespace sdi12 {
+namespace testing {
+
+class TestBoard : public SDI12HostHal {
+ public:
+  /// Called with each command received on a line, including its address and the '!'
+  using Responder = std::function<void(const std::string &command)>;
+
+  /// Wire a sensor to the recorder, which receives on @p rx_pin and transmits on @p tx_pin
+  void add_line(uint8_t rx_pin, uint8_t tx_pin, Responder responder) {
+    Line line;
+    line.rx_pin = rx_pin;
+    line.tx_pin = tx_pin;
+    line.responder = std::move(responder);
+    this->lines_.push_back(std::move(line));
+    // the idle line is marking
+    this->levels_[rx_pin % SDI12_HOST_PINS] = HIGH;
+  }
+
+  /**
+   * Put @p data on @p rx_pin, the first start bit @p delay_us after the end of the
+   * command being answered, or after now outside of a responder. 7E1 characters, or 8N1
+   * bytes if @p binary.
+   */
+  void transmit(uint8_t rx_pin, const std::string &data, uint32_t delay_us, bool binary = false) {
+    uint64_t start = (this->responding_ ? this->command_end_us_ : this->now_us_) + delay_us;
+    uint8_t level = HIGH;
+    for (size_t i = 0; i < data.size(); i++) {
+      uint8_t c = static_cast<uint8_t>(data[i]);
+      if (!binary)
+        c = (c & 0x7F) | (__builtin_parity(c & 0x7F) << 7);
+      // start bit, 8 data or 7 data and parity bits, stop bit
+      uint16_t bits = static_cast<uint16_t>(c) << 1 | 1 << 9;
+      uint64_t char_start = start + i * SDI12_CHARACTER_US;
+      for (uint8_t bit = 0; bit < 10; bit++) {
+        uint8_t next = (bits >> bit) & 1 ? HIGH : LOW;
+        if (next == level)
+          continue;
+        level = next;
+        this->schedule_(rx_pin, char_start + sdi12_bits_to_micros(bit) - start, start, level);
+      }
+    }
+  }
+
+  /// Clock error of the transmitting sensors in ppm, positive is slow
+  void set_skew(int32_t skew_ppm) { this->skew_ppm_ = skew_ppm; }
+  /// Every edge is moved by up to ±@p jitter_us
+  void set_jitter(uint32_t jitter_us) { this->jitter_us_ = jitter_us; }
+  /// An interrupt of up to @p latency_us runs right before each transition of a Tx pin and delays it
+  void set_tx_latency(uint32_t latency_us) { this->tx_latency_us_ = latency_us; }
+
+  /// The commands received on the line of @p rx_pin
+  const std::vector<std::string> &commands(uint8_t rx_pin) { return this->line_(rx_pin)->commands; }
+  /// The breaks of at least 12 ms received on the line of @p rx_pin
+  uint32_t breaks(uint8_t rx_pin) { return this->line_(rx_pin)->breaks; }
+
+  uint32_t micros() override {
+    this->deliver_();
+    return SDI12HostHal::micros();
+  }
+  uint32_t millis() override {
+    this->deliver_();
+    return SDI12HostHal::millis();
+  }
+  /// The edges up to now reach the handlers first, as they would have on a device
+  void mask_interrupts() override {
+    this->deliver_();
+    SDI12HostHal::mask_interrupts();
+  }
+  void digital_write(uint8_t pin, uint8_t level) override {
+    for (auto &line : this->lines_) {
+      if (line.tx_pin != pin || line.tx_level == level)
+        continue;
+      if (this->tx_latency_us_ > 0)
+        this->advance(this->random_() % (this->tx_latency_us_ + 1));
+      this->tx_edge_(line, level);
+    }
+    SDI12HostHal::digital_write(pin, level);
+  }
+
+ protected:
+  struct Line {
+    uint8_t rx_pin;
+    uint8_t tx_pin;
+    Responder responder;
+    /// the Tx pin is LOW while marking
+    uint8_t tx_level{LOW};
+    /// a character is being received since its start bit at char_start
+    bool in_char{false};
+    uint64_t char_start{0};
+    /// the transitions of the Tx pin since char_start
+    std::vector<std::pair<uint64_t, uint8_t>> edges;
+    /// spacing for longer than a character, until the line returns to marking
+    bool in_break{false};
+    std::string command;
+    std::vector<std::string> commands;
+    uint32_t breaks{0};
+  };
+  struct RxEdge {
+    uint8_t pin;
+    uint8_t level;
+  };
+
+  Line *line_(uint8_t rx_pin) {
+    for (auto &line : this->lines_) {
+      if (line.rx_pin == rx_pin)
+        return &line;
+    }
+    return nullptr;
+  }
+
+  void schedule_(uint8_t pin, uint64_t offset, uint64_t start, uint8_t level) {
+    int64_t time = start + offset + static_cast<int64_t>(offset) * this->skew_ppm_ / 1000000;
+    if (this->jitter_us_ > 0)
+      time += static_cast<int64_t>(this->random_() % (2 * this->jitter_us_ + 1)) - this->jitter_us_;
+    this->rx_edges_.emplace(static_cast<uint64_t>(time), RxEdge{pin, level});
+  }
+
+  uint32_t random_() {
+    this->random_state_ ^= this->random_state_ << 13;
+    this->random_state_ ^= this->random_state_ >> 17;
+    this->random_state_ ^= this->random_state_ << 5;
+    return this->random_state_;
+  }
+
+  void tx_edge_(Line &line, uint8_t level) {
+    this->decode_(line, this->now_us_);
+    line.tx_level = level;
+    if (line.in_break) {
+      if (level == LOW) {
+        line.in_break = false;
+        // a break wakes the sensor and resets what it received
+        if (this->now_us_ - line.char_start >= 12000)
+          line.breaks++;
+        line.command.clear();
+      }
+      return;
+    }
+    if (!line.in_char) {
+      if (level != HIGH)
+        return;
+      line.in_char = true;
+      line.char_start = this->now_us_;
+      line.edges.clear();
+    }
+    line.edges.emplace_back(this->now_us_, level);
+  }
+
+  /**
+   * Sample the character on the Tx pin once the middle of its stop bit has passed, from
+   * then on the sensor looks for the next start bit like a UART does
+   */
+  void decode_(Line &line, uint64_t now) {
+    if (!line.in_char || now < line.char_start + (sdi12_bits_to_micros(9) + sdi12_bits_to_micros(10)) / 2)
+      return;
+    line.in_char = false;
+    uint16_t bits = 0;
+    for (uint8_t bit = 0; bit < 10; bit++) {
+      uint64_t centre = line.char_start + (sdi12_bits_to_micros(bit) + sdi12_bits_to_micros(bit + 1)) / 2;
+      uint8_t level = LOW;
+      for (auto &edge : line.edges) {
+        if (edge.first <= centre)
+          level = edge.second;
+      }
+      // on the Tx pin LOW is marking (1)
+      if (level == LOW)
+        bits |= 1 << bit;
+    }
+    if (!(bits & 1 << 9)) {
+      // no stop bit, the recorder holds the line spacing: a break
+      line.in_break = true;
+      return;
+    }
+    char c = static_cast<char>((bits >> 1) & 0x7F);
+    line.command += c;
+    if (c != '!')
+      return;
+    std::string command = line.command;
+    line.command.clear();
+    line.commands.push_back(command);
+    this->responding_ = true;
+    this->command_end_us_ = line.char_start + sdi12_bits_to_micros(10);
+    line.responder(command);
+    this->responding_ = false;
+  }
+
+  /// Apply the Rx edges that are due, each with the clock at its own time
+  void deliver_() {
+    if (this->delivering_)
+      return;
+    this->delivering_ = true;
+    for (auto &line : this->lines_)
+      this->decode_(line, this->now_us_);
+    uint64_t now = this->now_us_;
+    while (!this->rx_edges_.empty() && this->rx_edges_.begin()->first <= now) {
+      auto edge = *this->rx_edges_.begin();
+      this->rx_edges_.erase(this->rx_edges_.begin());
+      this->now_us_ = edge.first;
+      this->set_input(edge.second.pin, edge.second.level);
+    }
+    this->now_us_ = now;
+    this->delivering_ = false;
+  }
+
+  std::vector<Line> lines_;
+  std::multimap<uint64_t, RxEdge> rx_edges_;
+  int32_t skew_ppm_{0};
+  uint32_t jitter_us_{0};
+  uint32_t tx_latency_us_{0};
+  uint32_t random_state_{2463534242UL};
+  bool delivering_{false};
+  bool responding_{false};
+  uint64_t command_end_us_{0};
+};
+
+}  // namespace testing
+}  // namespace sdi12
+}  // namespace esphome
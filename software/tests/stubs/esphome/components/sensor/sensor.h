@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace sensor {
+
+/// A sensor that keeps what was published to it
+class Sensor {
+ public:
+  explicit Sensor(const std::string &name = "") : name_(name) {}
+  void publish_state(float state) {
+    this->state = state;
+    this->has_state_ = true;
+    this->publishes_++;
+  }
+  bool has_state() const { return this->has_state_; }
+  uint32_t get_publishes() const { return this->publishes_; }
+  const std::string &get_name() const { return this->name_; }
+
+  float state{NAN};
+
+ protected:
+  std::string name_;
+  bool has_state_{false};
+  uint32_t publishes_{0};
+};
+
+}  // namespace sensor
+}  // namespace esphome
+
+#define LOG_SENSOR(prefix, type, obj) \
+  if ((obj) != nullptr) { \
+    ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->get_name().c_str()); \
+  }
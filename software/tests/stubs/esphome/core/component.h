@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome {
+
+namespace setup_priority {
+inline constexpr float BUS = 1000.0f;
+inline constexpr float IO = 900.0f;
+inline constexpr float HARDWARE = 800.0f;
+inline constexpr float DATA = 600.0f;
+}  // namespace setup_priority
+
+/// The part of esphome::Component the SDI-12 code uses
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return setup_priority::DATA; }
+
+ protected:
+  /// There is no scheduler on the test host, a test calls what it needs itself
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {}
+  void set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {}
+};
+
+class PollingComponent : public Component {
+ public:
+  PollingComponent() = default;
+  explicit PollingComponent(uint32_t update_interval) : update_interval_(update_interval) {}
+  virtual void update() = 0;
+  void set_update_interval(uint32_t update_interval) { this->update_interval_ = update_interval; }
+  uint32_t get_update_interval() const { return this->update_interval_; }
+
+ protected:
+  uint32_t update_interval_{60000};
+};
+
+}  // namespace esphome
@@ -0,0 +1,4 @@
+#pragma once
+
+#define USE_SENSOR
+#define USE_SDI12_EMULATOR
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace esphome {
+
+/// The part of esphome::InternalGPIOPin the SDI-12 code uses, the pin itself is driven by sdi12_host.h
+class InternalGPIOPin {
+ public:
+  virtual ~InternalGPIOPin() = default;
+  virtual void setup() {}
+  virtual uint8_t get_pin() const = 0;
+  virtual std::string dump_summary() const { return "GPIO" + std::to_string(this->get_pin()); }
+};
+
+}  // namespace esphome
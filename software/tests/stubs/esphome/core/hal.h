@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include "esphome/core/gpio.h"
+
+namespace esphome {
+
+// Real time, the SDI-12 code itself runs on the virtual clock of sdi12_host.h
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+}  // namespace esphome
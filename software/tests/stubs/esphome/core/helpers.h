@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace esphome {
+
+uint32_t fnv1_hash(const std::string &str);
+/// Deterministic on the test host, see set_random_seed()
+uint32_t random_uint32();
+float random_float();
+void set_random_seed(uint32_t seed);
+
+class HighFrequencyLoopRequester {
+ public:
+  void start() { this->started_ = true; }
+  void stop() { this->started_ = false; }
+  bool is_started() const { return this->started_; }
+
+ protected:
+  bool started_{false};
+};
+
+}  // namespace esphome
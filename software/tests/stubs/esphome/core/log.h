@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdio>
+
+#define ESPHOME_LOG_LEVEL_NONE 0
+#define ESPHOME_LOG_LEVEL_ERROR 1
+#define ESPHOME_LOG_LEVEL_WARN 2
+#define ESPHOME_LOG_LEVEL_INFO 3
+#define ESPHOME_LOG_LEVEL_CONFIG 4
+#define ESPHOME_LOG_LEVEL_DEBUG 5
+#define ESPHOME_LOG_LEVEL_VERBOSE 6
+
+namespace esphome {
+
+/// Messages up to this level are printed, ESPHOME_LOG_LEVEL from the environment or errors only
+int log_level();
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+}  // namespace esphome
+
+#define ESP_LOG_AT_(level, tag, ...) \
+  do { \
+    if (::esphome::log_level() >= (level)) \
+      ::esphome::esp_log_printf_(level, tag, __LINE__, __VA_ARGS__); \
+  } while (0)
+
+#define ESP_LOGE(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_CONFIG, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
+
+#define YESNO(b) ((b) ? "YES" : "NO")
+
+#define LOG_PIN(prefix, pin) \
+  if ((pin) != nullptr) { \
+    ESP_LOGCONFIG(TAG, prefix "%s", (pin)->dump_summary().c_str()); \
+  }
+
+#define LOG_UPDATE_INTERVAL(this) \
+  ESP_LOGCONFIG(TAG, "  Update Interval: %.1fs", (this)->get_update_interval() / 1000.0f)
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace esphome {
+
+/// A preference backed by memory, it keeps its data as long as the ESPPreferences it came from
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  ESPPreferenceObject(std::vector<uint8_t> *data, uint32_t *saves) : data_(data), saves_(saves) {}
+
+  template<typename T> bool save(const T *src) {
+    if (this->data_ == nullptr)
+      return false;
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(src);
+    this->data_->assign(bytes, bytes + sizeof(T));
+    (*this->saves_)++;
+    return true;
+  }
+  template<typename T> bool load(T *dest) {
+    if (this->data_ == nullptr || this->data_->size() != sizeof(T))
+      return false;
+    std::memcpy(dest, this->data_->data(), sizeof(T));
+    return true;
+  }
+
+ protected:
+  std::vector<uint8_t> *data_{nullptr};
+  uint32_t *saves_{nullptr};
+};
+
+/// The flash of the test host, survives a "reboot" as long as the test keeps it
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash) {
+    return ESPPreferenceObject(&this->store_[type], &this->saves_);
+  }
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type) {
+    return this->make_preference<T>(type, false);
+  }
+  /// Number of saves since the last reset
+  uint32_t saves() const { return this->saves_; }
+  /// Erase the flash
+  void reset() {
+    this->store_.clear();
+    this->saves_ = 0;
+  }
+
+ protected:
+  std::map<uint32_t, std::vector<uint8_t>> store_;
+  uint32_t saves_{0};
+};
+
+extern ESPPreferences *global_preferences;
+
+}  // namespace esphome
@@ -0,0 +1,68 @@
+// The ESPHome core functions the SDI-12 component calls, for the test host
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <thread>
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+
+static std::chrono::steady_clock::time_point boot() {
+  static const auto time = std::chrono::steady_clock::now();
+  return time;
+}
+
+uint32_t micros() {
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - boot()).count());
+}
+uint32_t millis() { return micros() / 1000; }
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+void yield() {}
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= static_cast<uint8_t>(c);
+  }
+  return hash;
+}
+
+static uint32_t random_state = 1;
+void set_random_seed(uint32_t seed) { random_state = seed != 0 ? seed : 1; }
+uint32_t random_uint32() {
+  // xorshift32, the same sequence on every run
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+float random_float() { return static_cast<float>(random_uint32() >> 8) / static_cast<float>(1 << 24); }
+
+int log_level() {
+  static const int level = [] {
+    const char *env = std::getenv("ESPHOME_LOG_LEVEL");
+    return env != nullptr ? std::atoi(env) : ESPHOME_LOG_LEVEL_ERROR;
+  }();
+  return level;
+}
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...) {
+  static const char LETTERS[] = "-EWICDV";
+  std::fprintf(stderr, "[%c][%s:%d]: ", LETTERS[level], tag, line);
+  va_list args;
+  va_start(args, format);
+  std::vfprintf(stderr, format, args);
+  va_end(args);
+  std::fputc('\n', stderr);
+}
+
+static ESPPreferences preferences;
+ESPPreferences *global_preferences = &preferences;
+
+}  // namespace esphome
@@ -0,0 +1,84 @@
+// Binary packets through the bit-banged line, in particular those whose last byte ends
+// in 1's and therefore has no closing transition
+#include <cstring>
+#include <string>
+#include "sdi12_test.h"
+#include "sdi12_test_board.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+static const uint8_t RX_PIN = 4;
+static const uint8_t TX_PIN = 5;
+static const uint8_t OE_PIN = 6;
+static const uint32_t LATENCY_US = 9000;
+
+// A packet of one UINT16 value, with its CRC least significant byte first
+static std::string make_packet(uint16_t value) {
+  std::string packet = {'0', 2, 0, static_cast<char>(SDI12BinaryType::UINT16), static_cast<char>(value & 0xFF),
+                        static_cast<char>(value >> 8)};
+  uint16_t crc = sdi12_crc16(packet.data(), packet.length());
+  packet += static_cast<char>(crc & 0xFF);
+  packet += static_cast<char>(crc >> 8);
+  return packet;
+}
+
+static void run(bool deferred_decoding) {
+  TestBoard board;
+  set_sdi12_host_hal(&board);
+  std::string packet;
+  board.add_line(RX_PIN, TX_PIN, [&](const std::string &command) {
+    if (command == "0HB!") {
+      board.transmit(RX_PIN, "0000001\r\n", LATENCY_US);
+    } else if (command == "0DB0!") {
+      board.transmit(RX_PIN, packet, LATENCY_US, true);
+    }
+  });
+
+  TestPin rx(RX_PIN), tx(TX_PIN), oe(OE_PIN);
+  SDI12Bus bus;
+  bus.set_rx_pin(&rx);
+  bus.set_tx_pin(&tx);
+  bus.set_oe_pin(&oe);
+  bus.set_deferred_decoding(deferred_decoding);
+  TestDevice device;
+  device.set_sdi12_address("0");
+  device.set_sdi12_bus(&bus);
+  bus.setup();
+  esphome::Component *loop = &bus;
+
+  // values whose CRC ends in a byte with bits 6 and 7 set, and some that don't
+  int high = 0, low = 0;
+  for (uint16_t value = 0; high < 8 || low < 2; value++) {
+    packet = make_packet(value);
+    bool ends_in_ones = static_cast<uint8_t>(packet.back()) >= 0xC0;
+    if (ends_in_ones ? high++ >= 8 : low++ >= 2)
+      continue;
+
+    bool done = false;
+    SDI12Status status = SDI12Status::NOT_INITIALIZED;
+    size_t count = 0;
+    double received = -1;
+    uint32_t retries = bus.get_retry_count();
+    device.start_binary_measurement_([&](SDI12Status s, const SDI12BinaryPacket &p) {
+      status = s;
+      count = p.count();
+      if (count > 0)
+        received = p.value(0);
+      done = p.last;
+    });
+    SDI12_CHECK(run_until({loop}, [&] { return done; }, 2000000));
+    SDI12_CHECK(status == SDI12Status::OK);
+    SDI12_CHECK_EQ(count, 1u);
+    SDI12_CHECK_EQ(received, static_cast<double>(value));
+    // the packet is complete without waiting for a timeout and a retry
+    SDI12_CHECK_EQ(bus.get_retry_count(), retries);
+    SDI12_CHECK_EQ(bus.get_crc_errors(), 0u);
+  }
+}
+
+int main() {
+  run(false);
+  run(true);
+  return result("test_binary_packets");
+}
@@ -0,0 +1,153 @@
+// The receiver against sensors with a skewed clock and jittery edges: the character
+// error rate over a sweep, zero within the tolerance of the 1 µs bit timing, and across
+// the wrap-around of micros(). The transmitter against interrupts that delay its
+// transitions: no command is lost while they stay within half a bit.
+#include <cstdio>
+#include <string>
+#include "sdi12_test.h"
+#include "sdi12_test_board.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+static const uint8_t RX_PIN = 4;
+static const uint8_t TX_PIN = 5;
+static const uint8_t OE_PIN = 6;
+static const uint32_t LATENCY_US = 9000;
+// every 7E1 bit pattern the data of a response can have
+static const std::string DATA = "0+1.234-56.78+9.0e-3+0.5-0.25+12345.678-0.001+3.14159+2.71828-1.41421+7";
+static const int RESPONSES = 5;
+// a command with most of the characters one can have
+static const char COMMAND_ACTION[] = "XSET+1.25e-3,7;ZZ~";
+static const int COMMANDS = 20;
+
+struct Errors {
+  uint32_t characters;
+  uint32_t wrong;
+};
+
+static Errors run(int32_t skew_ppm, uint32_t jitter_us, uint64_t start_us = 0) {
+  TestBoard board;
+  set_sdi12_host_hal(&board);
+  board.advance(start_us);
+  board.set_skew(skew_ppm);
+  board.set_jitter(jitter_us);
+  board.add_line(RX_PIN, TX_PIN, [&](const std::string &command) {
+    if (command == "0R0!")
+      board.transmit(RX_PIN, DATA + "\r\n", LATENCY_US);
+  });
+  TestPin rx(RX_PIN), tx(TX_PIN), oe(OE_PIN);
+  SDI12Bus bus;
+  bus.set_rx_pin(&rx);
+  bus.set_tx_pin(&tx);
+  bus.set_oe_pin(&oe);
+  // every response counts once, as received
+  bus.set_retries(0);
+  bus.set_adaptive_timing(false);
+  TestDevice device;
+  device.set_sdi12_address("0");
+  device.set_sdi12_bus(&bus);
+  bus.setup();
+  esphome::Component *loop = &bus;
+
+  Errors errors{0, 0};
+  for (int i = 0; i < RESPONSES; i++) {
+    bool done = false;
+    std::string response;
+    device.read_continuous_(0, [&](SDI12Status status, std::string_view r) {
+      response = std::string(r);
+      done = true;
+    });
+    run_until({loop}, [&] { return done; }, 2000000);
+    std::string expected = DATA + "\r\n";
+    errors.characters += expected.size();
+    // a lost character shifts the rest, which count as wrong as well
+    for (size_t c = 0; c < expected.size(); c++) {
+      if (c >= response.size() || response[c] != expected[c])
+        errors.wrong++;
+    }
+  }
+  // a character can be right by chance with its parity wrong
+  auto counters = bus.get_line_counters();
+  if (counters.parity_errors + counters.framing_errors > errors.wrong)
+    errors.wrong = counters.parity_errors + counters.framing_errors;
+  return errors;
+}
+
+// The commands of COMMANDS sent that the sensor received intact, with every Tx transition
+// delayed by an interrupt of up to @p tx_latency_us
+static int commands_received(uint32_t tx_latency_us) {
+  TestBoard board;
+  set_sdi12_host_hal(&board);
+  board.set_tx_latency(tx_latency_us);
+  board.add_line(RX_PIN, TX_PIN, [](const std::string &command) {});
+  TestPin rx(RX_PIN), tx(TX_PIN), oe(OE_PIN);
+  SDI12Bus bus;
+  bus.set_rx_pin(&rx);
+  bus.set_tx_pin(&tx);
+  bus.set_oe_pin(&oe);
+  bus.set_retries(0);
+  bus.set_adaptive_timing(false);
+  TestDevice device;
+  device.set_sdi12_address("0");
+  device.set_sdi12_bus(&bus);
+  bus.setup();
+  esphome::Component *loop = &bus;
+
+  std::string expected = std::string("0") + COMMAND_ACTION + "!";
+  for (int i = 0; i < COMMANDS; i++) {
+    bool done = false;
+    device.send_command_(device.command_(std::string(COMMAND_ACTION) + "!"),
+                         [&](SDI12Status status, std::string_view r) { done = true; });
+    run_until({loop}, [&] { return done; }, 2000000);
+  }
+  int received = 0;
+  for (const auto &command : board.commands(RX_PIN))
+    received += command == expected;
+  return received;
+}
+
+int main() {
+  // the sweep, for the record
+  const int32_t skews[] = {0, 10000, 20000, 30000, 40000, 50000, 60000};
+  const uint32_t jitters[] = {0, 100, 200, 300, 400};
+  std::printf("character error rate vs. clock skew (rows, ppm) and edge jitter (columns, ±µs)\n%8s", "");
+  for (uint32_t jitter : jitters)
+    std::printf("%8u", jitter);
+  std::printf("\n");
+  for (int32_t skew : skews) {
+    std::printf("%+8d", skew);
+    for (uint32_t jitter : jitters) {
+      Errors errors = run(skew, jitter);
+      std::printf("%8.3f", static_cast<double>(errors.wrong) / errors.characters);
+    }
+    std::printf("\n");
+  }
+
+  // within the tolerance of the receiver, a bit is misread once the level before an
+  // edge is off by half a bit: a clock off by 2 % (0.18 bit over a character), fast or
+  // slow, with edges moved by ±100 µs (up to 0.24 bit on a level), and ±200 µs alone
+  for (int32_t skew : {-20000, 0, 20000}) {
+    for (uint32_t jitter : {0u, 100u, skew == 0 ? 200u : 100u}) {
+      Errors errors = run(skew, jitter);
+      if (errors.wrong != 0)
+        std::fprintf(stderr, "skew %d ppm, jitter %u µs: %u of %u characters wrong\n", skew, jitter, errors.wrong,
+                     errors.characters);
+      SDI12_CHECK_EQ(errors.wrong, 0u);
+    }
+  }
+
+  // Interrupts stay enabled while a character is sent, each transition is timed from the
+  // start bit, so an interrupt only delays the transition right after it. The sensor
+  // samples in the middle of a bit, a transition may be off by less than half a bit
+  // (416 µs) against the start bit: 300 µs are fine, far more than the Rx interrupts of
+  // the other lines take.
+  SDI12_CHECK_EQ(commands_received(300), COMMANDS);
+  SDI12_CHECK(commands_received(1000) < COMMANDS);
+
+  // micros() wraps around within the responses
+  Errors errors = run(10000, 100, (1ULL << 32) - 300000);
+  SDI12_CHECK_EQ(errors.wrong, 0u);
+
+  return result("test_bit_timing");
+}
@@ -0,0 +1,134 @@
+// The SDI-12 CRC: known answers, the table against a bitwise reference, the check and
+// removal on text responses and binary packets, and detection of corrupted characters
+#include <string>
+#include "sdi12_test.h"
+#include "sdi12/sdi12_buffer.h"
+#include "sdi12/sdi12_crc.h"
+
+using namespace esphome::sdi12;
+
+// CRC-16/ARC one bit at a time, as the specification describes it
+static uint16_t reference_crc16(const std::string &data) {
+  uint16_t crc = 0;
+  for (char c : data) {
+    crc ^= static_cast<uint8_t>(c);
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+  }
+  return crc;
+}
+
+static std::string with_crc(const std::string &response) {
+  uint16_t crc = sdi12_crc16(response.data(), response.length());
+  std::string out = response;
+  for (uint8_t i = 0; i < 3; i++)
+    out += sdi12_crc_char(crc, i);
+  return out + "\r\n";
+}
+
+static void test_known_answers() {
+  struct Vector {
+    const char *data;
+    uint16_t crc;
+  };
+  // the check value of CRC-16/ARC, the example of the specification, and a few responses
+  const Vector vectors[] = {
+      {"", 0x0000},
+      {"A", 0x30C0},
+      {"123456789", 0xBB3D},
+      {"0+3.14", 0xFC5A},
+      {"0+3.14-2.5", 0xFCA7},
+      {"1+12.345-0.001+1e3", 0x985E},
+  };
+  for (auto &vector : vectors) {
+    std::string data = vector.data;
+    SDI12_CHECK_EQ(sdi12_crc16(data.data(), data.length()), vector.crc);
+  }
+  SDI12_CHECK_EQ(with_crc("0+3.14"), "0+3.14OqZ\r\n");
+
+  // every character each table entry is reached by, and longer strings of all of them
+  std::string all;
+  for (int c = 0; c < 256; c++) {
+    std::string one(1, static_cast<char>(c));
+    SDI12_CHECK_EQ(sdi12_crc16(one.data(), 1), reference_crc16(one));
+    all += one;
+  }
+  for (size_t length = 0; length <= all.size(); length += 17)
+    SDI12_CHECK_EQ(sdi12_crc16(all.data(), length), reference_crc16(all.substr(0, length)));
+
+  // the encoding uses only printable characters 0x40 to 0x7F
+  for (uint32_t crc = 0; crc <= 0xFFFF; crc += 0x0101) {
+    for (uint8_t i = 0; i < 3; i++) {
+      char c = sdi12_crc_char(crc, i);
+      SDI12_CHECK(c >= 0x40 && c <= 0x7F);
+    }
+  }
+}
+
+static void test_text_check() {
+  std::string response = "0+3.14OqZ\r\n";
+  SDI12_CHECK(sdi12_check_crc(response));
+  // the CRC is removed, the values parse as without one
+  SDI12_CHECK_EQ(response, "0+3.14\r\n");
+
+  // the same on the fixed buffer of the bus
+  SDI12Response buffer;
+  buffer.assign(with_crc("1+12.345-0.001+1e3"));
+  SDI12_CHECK(sdi12_check_crc(buffer));
+  SDI12_CHECK_EQ(std::string(std::string_view(buffer)), "1+12.345-0.001+1e3\r\n");
+
+  // too short for address, CRC and <CR><LF>
+  std::string short_response = "0OqZ\r";
+  SDI12_CHECK(!sdi12_check_crc(short_response));
+
+  // every single-bit error of every character is detected, and the response left alone
+  const std::string good = with_crc("0+21.5-3.25+1013.2");
+  int missed = 0;
+  for (size_t at = 0; at < good.length() - 2; at++) {
+    for (int bit = 0; bit < 7; bit++) {
+      std::string bad = good;
+      bad[at] ^= 1 << bit;
+      if (sdi12_check_crc(bad) || bad.length() != good.length())
+        missed++;
+    }
+  }
+  SDI12_CHECK_EQ(missed, 0);
+
+  // and swapped neighbours, which parity can't see
+  for (size_t at = 0; at + 1 < good.length() - 5; at++) {
+    std::string bad = good;
+    std::swap(bad[at], bad[at + 1]);
+    if (bad != good)
+      SDI12_CHECK(!sdi12_check_crc(bad));
+  }
+}
+
+static void test_binary_check() {
+  std::string packet = {'0', 4, 0, 4, 0x34, 0x12, static_cast<char>(0xCD), static_cast<char>(0xAB)};
+  uint16_t crc = reference_crc16(packet);
+  std::string good = packet + static_cast<char>(crc & 0xFF) + static_cast<char>(crc >> 8);
+  std::string checked = good;
+  SDI12_CHECK(sdi12_check_binary_crc(checked));
+  SDI12_CHECK_EQ(checked.size(), packet.size());
+  SDI12_CHECK(checked == packet);
+
+  // the CRC is least significant byte first
+  std::string swapped = packet + static_cast<char>(crc >> 8) + static_cast<char>(crc & 0xFF);
+  SDI12_CHECK(!sdi12_check_binary_crc(swapped));
+  for (size_t at = 0; at < good.size(); at++) {
+    for (int bit = 0; bit < 8; bit++) {
+      std::string bad = good;
+      bad[at] ^= 1 << bit;
+      SDI12_CHECK(!sdi12_check_binary_crc(bad));
+    }
+  }
+  std::string tiny = "0\x01";
+  SDI12_CHECK(!sdi12_check_binary_crc(tiny));
+}
+
+int main() {
+  test_known_answers();
+  test_text_check();
+  test_binary_check();
+  return esphome::sdi12::testing::result("test_crc");
+}
@@ -0,0 +1,178 @@
+// SDI12EdgeDecoder on edge streams: every 7E1 character and 8N1 byte, parity and framing
+// errors, characters back to back and the flush of a last character ending in 1's
+#include <string>
+#include <vector>
+#include "sdi12_test.h"
+#include "sdi12/sdi12_decoder.h"
+
+using namespace esphome::sdi12;
+
+// The transitions of the Rx pin (HIGH is marking) for the 10 bits in @p bits, LSB first
+static void add_frame(std::vector<SDI12Edge> &edges, uint32_t start, uint16_t bits, uint8_t &level) {
+  for (uint8_t bit = 0; bit < 10; bit++) {
+    uint8_t next = (bits >> bit) & 1;
+    if (next != level) {
+      edges.push_back({start + sdi12_bits_to_micros(bit), next});
+      level = next;
+    }
+  }
+}
+
+// start bit, 7 data bits, even parity unless @p bad_parity, stop bit unless @p no_stop
+static uint16_t frame_7e1(uint8_t c, bool bad_parity = false, bool no_stop = false) {
+  uint8_t parity = __builtin_parity(c & 0x7F) ^ (bad_parity ? 1 : 0);
+  return (c & 0x7F) << 1 | parity << 8 | (no_stop ? 0 : 1 << 9);
+}
+static uint16_t frame_8n1(uint8_t c) { return c << 1 | 1 << 9; }
+
+// Feed @p edges and flush a character time after the last, return what was received
+static std::string decode(SDI12EdgeDecoder &decoder, const std::vector<SDI12Edge> &edges, uint32_t end) {
+  std::string out;
+  uint8_t c;
+  for (auto &edge : edges) {
+    if (decoder.feed(edge.time, edge.level, c))
+      out += static_cast<char>(c);
+  }
+  // not yet: the last character may still be going on
+  if (!edges.empty() && decoder.flush(edges.back().time + sdi12_bits_to_micros(1), c))
+    out += '?';
+  if (decoder.flush(end, c))
+    out += static_cast<char>(c);
+  return out;
+}
+
+static void test_every_character() {
+  SDI12EdgeDecoder decoder;
+  uint32_t time = 1000;
+  for (int c = 0; c < 128; c++) {
+    std::vector<SDI12Edge> edges;
+    uint8_t level = 1;
+    add_frame(edges, time, frame_7e1(c), level);
+    std::string out = decode(decoder, edges, time + sdi12_bits_to_micros(11));
+    SDI12_CHECK_EQ(out.size(), 1u);
+    if (out.size() == 1)
+      SDI12_CHECK_EQ(static_cast<int>(static_cast<uint8_t>(out[0])), c);
+    time += 20000;
+  }
+  SDI12_CHECK_EQ(decoder.parity_errors(), 0u);
+  SDI12_CHECK_EQ(decoder.framing_errors(), 0u);
+}
+
+static void test_every_byte() {
+  SDI12EdgeDecoder decoder;
+  decoder.set_binary(true);
+  uint32_t time = 5000;
+  // back to back, as in a packet, the last byte only completed by the flush
+  std::vector<SDI12Edge> edges;
+  uint8_t level = 1;
+  for (int c = 0; c < 256; c++)
+    add_frame(edges, time + c * sdi12_bits_to_micros(10), frame_8n1(c), level);
+  std::string out = decode(decoder, edges, time + 256 * sdi12_bits_to_micros(10) + sdi12_bits_to_micros(1));
+  SDI12_CHECK_EQ(out.size(), 256u);
+  for (size_t c = 0; c < out.size(); c++) {
+    if (static_cast<uint8_t>(out[c]) != c) {
+      SDI12_CHECK_EQ(static_cast<int>(static_cast<uint8_t>(out[c])), static_cast<int>(c));
+      break;
+    }
+  }
+  // every value as the last byte of a packet
+  for (int c = 0; c < 256; c++) {
+    std::vector<SDI12Edge> last;
+    uint8_t level = 1;
+    time += 50000;
+    add_frame(last, time, frame_8n1(c), level);
+    std::string out = decode(decoder, last, time + sdi12_bits_to_micros(10));
+    SDI12_CHECK_EQ(out.size(), 1u);
+    if (out.size() == 1 && static_cast<uint8_t>(out[0]) != c)
+      SDI12_CHECK_EQ(static_cast<int>(static_cast<uint8_t>(out[0])), c);
+  }
+  SDI12_CHECK_EQ(decoder.framing_errors(), 0u);
+}
+
+static void test_back_to_back_text() {
+  SDI12EdgeDecoder decoder;
+  const std::string text = "0+3.14-2.718+1e3\r\n~\x7F";
+  std::vector<SDI12Edge> edges;
+  uint8_t level = 1;
+  uint32_t time = 100;
+  for (size_t i = 0; i < text.size(); i++)
+    add_frame(edges, time + i * sdi12_bits_to_micros(10), frame_7e1(text[i]), level);
+  SDI12_CHECK_EQ(decode(decoder, edges, time + text.size() * sdi12_bits_to_micros(10) + 1000), text);
+  SDI12_CHECK_EQ(decoder.parity_errors(), 0u);
+  SDI12_CHECK_EQ(decoder.framing_errors(), 0u);
+}
+
+static void test_parity_errors() {
+  SDI12EdgeDecoder decoder;
+  std::vector<SDI12Edge> edges;
+  uint8_t level = 1;
+  uint32_t time = 100;
+  const std::string text = "0+1\r\n";
+  for (size_t i = 0; i < text.size(); i++)
+    add_frame(edges, time + i * sdi12_bits_to_micros(10), frame_7e1(text[i], i == 1 || i == 3), level);
+  // the characters still arrive, the errors are counted
+  SDI12_CHECK_EQ(decode(decoder, edges, time + 10 * sdi12_bits_to_micros(10)), text);
+  SDI12_CHECK_EQ(decoder.parity_errors(), 2u);
+  SDI12_CHECK_EQ(decoder.framing_errors(), 0u);
+
+  // a binary byte has no parity to check
+  SDI12EdgeDecoder binary;
+  binary.set_binary(true);
+  edges.clear();
+  level = 1;
+  add_frame(edges, time, frame_8n1(0x01), level);
+  decode(binary, edges, time + 20000);
+  SDI12_CHECK_EQ(binary.parity_errors(), 0u);
+}
+
+static void test_framing_errors() {
+  SDI12EdgeDecoder decoder;
+  std::vector<SDI12Edge> edges;
+  uint8_t level = 1;
+  uint32_t time = 100;
+  // a spacing stop bit, then the line returns to marking and a good character follows
+  add_frame(edges, time, frame_7e1('C', false, true), level);
+  edges.push_back({time + sdi12_bits_to_micros(12), 1});
+  level = 1;
+  add_frame(edges, time + 30000, frame_7e1('B'), level);
+  std::string out = decode(decoder, edges, time + 50000);
+  SDI12_CHECK_EQ(decoder.framing_errors(), 1u);
+  SDI12_CHECK(!out.empty() && out.back() == 'B');
+
+  // the parity bit is spacing already, the line stays so through the stop bit
+  edges.clear();
+  level = 1;
+  time += 100000;
+  add_frame(edges, time, frame_7e1('A', false, true), level);
+  edges.push_back({time + sdi12_bits_to_micros(12), 1});
+  level = 1;
+  add_frame(edges, time + 30000, frame_7e1('B'), level);
+  out = decode(decoder, edges, time + 50000);
+  SDI12_CHECK_EQ(decoder.framing_errors(), 2u);
+  SDI12_CHECK(!out.empty() && out.back() == 'B');
+  SDI12_CHECK_EQ(decoder.parity_errors(), 0u);
+}
+
+static void test_reset() {
+  SDI12EdgeDecoder decoder;
+  uint8_t c;
+  // half a character, then the line is handed over and the decoder reset
+  SDI12_CHECK(!decoder.feed(100, 0, c));
+  SDI12_CHECK(!decoder.feed(100 + sdi12_bits_to_micros(2), 1, c));
+  decoder.reset();
+  SDI12_CHECK(!decoder.flush(100000, c));
+  std::vector<SDI12Edge> edges;
+  uint8_t level = 1;
+  add_frame(edges, 200000, frame_7e1('z'), level);
+  SDI12_CHECK_EQ(decode(decoder, edges, 220000), "z");
+}
+
+int main() {
+  test_every_character();
+  test_every_byte();
+  test_back_to_back_text();
+  test_parity_errors();
+  test_framing_errors();
+  test_reset();
+  return esphome::sdi12::testing::result("test_decoder");
+}
@@ -0,0 +1,137 @@
+// Whole measurements against the emulated sensor on a loopback line: aM! with its service
+// request, aC! and aR0!, each with and without CRC and over several data pages, published
+// by the generic sensor; then with a sensor slowing down, and with responses dropped and
+// corrupted on the way
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "sdi12_test.h"
+#include "sdi12/sdi12_emulator.h"
+#include "sdi12/sdi12_sensor.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+// The emulated sensor measures i * 11.125 - 40 for value i, three decimals: four values
+// fill a 35 character page of aM!, nine values a 75 character page of aC!
+static float expected(size_t i) { return i * 11.125f - 40.0f; }
+
+struct Setup {
+  Setup(SDI12SensorCommand command, bool crc, size_t values) {
+    set_sdi12_host_hal(&this->hal);
+    this->bus.set_phy(&this->phy);
+    this->bus.set_wake_time(0);
+    this->emulated.set_phy(&this->phy);
+    this->emulated.set_measurement_time(1000);
+    for (size_t i = 0; i < values; i++)
+      this->emulated.add_value(expected(i), 0.0f, 0.0f, 3);
+    this->component.set_sdi12_address("0");
+    this->component.set_sdi12_bus(&this->bus);
+    this->component.set_sdi12_crc(crc);
+    this->component.set_command(command, 0);
+    for (size_t i = 0; i < values; i++) {
+      this->sensors.emplace_back(new esphome::sensor::Sensor("value"));
+      this->component.add_value(i, 1.0f, 0.0f, this->sensors.back().get());
+    }
+    this->bus.setup();
+  }
+
+  // Poll once and wait for the values, false if they never came
+  bool poll() {
+    uint32_t published = this->sensors[0]->get_publishes();
+    this->component.update();
+    esphome::Component *loop = &this->bus;
+    return run_until({loop}, [&] { return this->sensors[0]->get_publishes() > published; }, 10000000);
+  }
+
+  bool values_match() {
+    for (size_t i = 0; i < this->sensors.size(); i++) {
+      if (!this->sensors[i]->has_state() || std::fabs(this->sensors[i]->state - expected(i)) > 0.0005f)
+        return false;
+    }
+    return true;
+  }
+
+  SDI12HostHal hal;
+  SDI12LoopbackPhy phy;
+  SDI12Bus bus;
+  SDI12EmulatedSensor emulated;
+  SDI12SensorComponent component;
+  std::vector<std::unique_ptr<esphome::sensor::Sensor>> sensors;
+};
+
+static void test_measurement(SDI12SensorCommand command, bool crc, size_t values, const char *name) {
+  Setup setup(command, crc, values);
+  for (int i = 0; i < 3; i++) {
+    SDI12_CHECK(setup.poll());
+    if (!setup.values_match())
+      std::fprintf(stderr, "%s%s: values don't match\n", name, crc ? " with CRC" : "");
+    SDI12_CHECK(setup.values_match());
+  }
+  SDI12_CHECK_EQ(setup.bus.get_retry_count(), 0u);
+}
+
+// A corrupted response is asked for again right away, the CRC keeps the changed
+// characters out of the values. The loopback line has no parity, so only the responses
+// with a CRC are corrupted here: aRC0!
+static void test_corrupted_responses() {
+  Setup setup(SDI12SensorCommand::CONTINUOUS, true, 9);
+  setup.emulated.set_corrupt_rate(0.1f);
+  setup.bus.set_retries(3);
+  for (int i = 0; i < 50; i++) {
+    SDI12_CHECK(setup.poll());
+    SDI12_CHECK(setup.values_match());
+  }
+  SDI12_CHECK(setup.emulated.get_corrupted() > 0);
+  SDI12_CHECK_EQ(setup.bus.get_crc_errors(), setup.emulated.get_corrupted());
+  SDI12_CHECK(setup.bus.get_retry_count() >= setup.emulated.get_corrupted());
+}
+
+// A measurement whose response is lost fails, the next poll starts over and succeeds
+static void test_dropped_responses(SDI12SensorCommand command, size_t values) {
+  Setup setup(command, true, values);
+  setup.emulated.set_drop_rate(0.1f);
+  int ok = 0;
+  for (int i = 0; i < 30; i++) {
+    if (setup.poll()) {
+      ok++;
+      SDI12_CHECK(setup.values_match());
+    }
+  }
+  SDI12_CHECK(setup.emulated.get_dropped() > 0);
+  SDI12_CHECK(ok >= 15);
+}
+
+// A sensor that answers later than the first byte timeout it taught the bus, but within
+// the configured one: the command is repeated with the configured timing, no reading lost
+static void test_latency_jump() {
+  Setup setup(SDI12SensorCommand::CONTINUOUS, false, 4);
+  setup.emulated.set_latency(5);
+  for (int i = 0; i < 6; i++)
+    SDI12_CHECK(setup.poll());
+  setup.emulated.set_latency(12);
+  esphome::Component *loop = &setup.bus;
+  for (int i = 0; i < 3; i++) {
+    // after a full break, so the timeout is the only suspect
+    run_for({loop}, 200000);
+    SDI12_CHECK(setup.poll());
+    SDI12_CHECK(setup.values_match());
+  }
+  SDI12_CHECK_EQ(setup.bus.get_retry_count(), 0u);
+}
+
+int main() {
+  for (bool crc : {false, true}) {
+    // aM!: nine values on three pages, the end of the measurement by service request
+    test_measurement(SDI12SensorCommand::MEASURE, crc, 9, "aM!");
+    // aC!: twelve values on two pages
+    test_measurement(SDI12SensorCommand::CONCURRENT, crc, 12, "aC!");
+    // aR0!: one page
+    test_measurement(SDI12SensorCommand::CONTINUOUS, crc, 9, "aR0!");
+  }
+  test_latency_jump();
+  test_corrupted_responses();
+  test_dropped_responses(SDI12SensorCommand::MEASURE, 9);
+  test_dropped_responses(SDI12SensorCommand::CONCURRENT, 12);
+  return result("test_emulator");
+}
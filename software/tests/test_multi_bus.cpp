@@ -0,0 +1,94 @@
+// Several buses on their own pins of one board, each bit-banged and receiving at the same
+// time: the throughput scales with the number of lines and nothing crosses between them
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "sdi12_test.h"
+#include "sdi12_test_board.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+static const uint32_t LATENCY_US = 9000;
+static const uint64_t DURATION_US = 20000000;
+
+struct Line {
+  Line(TestBoard &board, uint8_t index)
+      : index(index), rx(10 + 3 * index), tx(11 + 3 * index), oe(12 + 3 * index) {
+    uint8_t rx_pin = this->rx.get_pin();
+    this->data = "0+" + std::to_string(index) + ".5+" + std::to_string(100 + index) + "-0.25+1.125";
+    board.add_line(rx_pin, this->tx.get_pin(), [this, &board, rx_pin](const std::string &command) {
+      if (command == "0R0!")
+        board.transmit(rx_pin, this->data + "\r\n", LATENCY_US);
+    });
+    this->bus.set_rx_pin(&this->rx);
+    this->bus.set_tx_pin(&this->tx);
+    this->bus.set_oe_pin(&this->oe);
+    this->bus.set_wake_time(0);
+    this->device.set_sdi12_address("0");
+    this->device.set_sdi12_bus(&this->bus);
+  }
+  // back to back reads of the line, each checked against what its own sensor sent
+  void poll() {
+    this->device.read_continuous_(0, [this](SDI12Status status, std::string_view response) {
+      if (status == SDI12Status::OK && response == this->data + "\r\n") {
+        this->good++;
+      } else {
+        this->bad++;
+      }
+      this->poll();
+    });
+  }
+
+  uint8_t index;
+  TestPin rx, tx, oe;
+  std::string data;
+  SDI12Bus bus;
+  TestDevice device;
+  uint32_t good{0};
+  uint32_t bad{0};
+};
+
+// transactions per second of all lines together
+static double run(size_t count) {
+  TestBoard board;
+  set_sdi12_host_hal(&board);
+  std::vector<std::unique_ptr<Line>> lines;
+  for (size_t i = 0; i < count; i++)
+    lines.emplace_back(new Line(board, i));
+  for (auto &line : lines) {
+    line->bus.setup();
+    line->poll();
+  }
+
+  uint64_t until = board.now_us() + DURATION_US;
+  while (board.now_us() < until) {
+    for (auto &line : lines)
+      static_cast<esphome::Component *>(&line->bus)->loop();
+    board.advance(200);
+  }
+
+  uint32_t good = 0;
+  for (auto &line : lines) {
+    SDI12_CHECK(line->good > 0);
+    SDI12_CHECK_EQ(line->bad, 0u);
+    auto counters = line->bus.get_line_counters();
+    SDI12_CHECK_EQ(counters.parity_errors + counters.framing_errors + counters.overflows, 0u);
+    good += line->good;
+  }
+  return good / (DURATION_US / 1e6);
+}
+
+int main() {
+  double single = run(1);
+  std::printf("1 bus: %.1f transactions/s\n", single);
+  for (size_t count = 2; count <= 4; count++) {
+    double rate = run(count);
+    std::printf("%u buses: %.1f transactions/s, %.2f times one bus\n", static_cast<unsigned>(count), rate,
+                rate / single);
+    // only the transmissions are serialized, they block the loop like on the device
+    SDI12_CHECK(rate >= 0.85 * count * single);
+  }
+  return result("test_multi_bus");
+}
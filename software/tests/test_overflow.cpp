@@ -0,0 +1,136 @@
+// A receive buffer that overflows before the response starts: the command is repeated
+// right away, not timed out as unanswered, and fails as a line error once the retries are
+// spent. On a mock PHY that reports the overflow like the bit-banged one.
+#include <cstring>
+#include <string>
+#include "sdi12_test.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+// Answers every command with "0\r\n" 9 ms later, after overflowing for the first few
+class OverflowPhy : public SDI12Phy {
+ public:
+  explicit OverflowPhy(uint32_t overflows) : overflows_left_(overflows) {}
+
+  void begin() override {}
+  void end() override {}
+  void send_break() override {}
+  void send_marking() override {}
+  void send_char(char c) override { delayMicroseconds(SDI12_CHARACTER_US); }
+  void end_frame() override {
+    this->frames++;
+    this->response_at_ = micros() + 9000;
+    this->pending_ = true;
+    this->overflowed_ = false;
+    this->received_.clear();
+  }
+  void listen() override {}
+  void set_binary(bool binary) override {}
+  int available() override {
+    this->deliver_();
+    if (this->overflowed_)
+      return -1;
+    return this->received_.size();
+  }
+  size_t read(uint8_t *buffer, size_t length) override {
+    this->deliver_();
+    this->overflowed_ = false;
+    size_t count = std::min(length, this->received_.size());
+    std::memcpy(buffer, this->received_.data(), count);
+    this->received_.erase(0, count);
+    return count;
+  }
+  void clear() override {
+    this->deliver_();
+    this->overflowed_ = false;
+    this->received_.clear();
+  }
+  uint32_t last_receive_time() const override { return this->response_at_; }
+  uint32_t last_activity_time() const override { return this->response_at_; }
+  SDI12LineCounters line_counters() const override { return {0, 0, this->overflow_count_}; }
+
+  uint32_t frames{0};
+
+ protected:
+  void deliver_() {
+    if (!this->pending_ || static_cast<int32_t>(micros() - this->response_at_) < 0)
+      return;
+    this->pending_ = false;
+    if (this->overflows_left_ > 0) {
+      // a burst of noise filled the buffer, the response is lost with it
+      this->overflows_left_--;
+      this->overflow_count_++;
+      this->overflowed_ = true;
+      return;
+    }
+    this->received_ = "0\r\n";
+  }
+
+  uint32_t overflows_left_;
+  uint32_t overflow_count_{0};
+  uint32_t response_at_{0};
+  bool pending_{false};
+  bool overflowed_{false};
+  std::string received_;
+};
+
+struct Result {
+  bool done{false};
+  SDI12Status status{SDI12Status::OK};
+  std::string response;
+  uint32_t duration_us{0};
+};
+
+static Result run(OverflowPhy &phy, uint8_t retries) {
+  SDI12HostHal hal;
+  set_sdi12_host_hal(&hal);
+  SDI12Bus bus;
+  bus.set_phy(&phy);
+  bus.set_wake_time(0);
+  bus.set_retries(retries);
+  TestDevice device;
+  device.set_sdi12_address("0");
+  device.set_sdi12_bus(&bus);
+  bus.setup();
+
+  Result result;
+  uint32_t start = hal.now_us();
+  device.send_command_(device.command_("!"), [&](SDI12Status status, std::string_view response) {
+    result.done = true;
+    result.status = status;
+    result.response = std::string(response);
+    result.duration_us = hal.now_us() - start;
+  });
+  esphome::Component *loop = &bus;
+  run_until({loop}, [&] { return result.done; }, 2000000, 100);
+  SDI12_CHECK(result.done);
+  SDI12_CHECK_EQ(static_cast<uint32_t>(bus.get_retry_count()), static_cast<uint32_t>(phy.frames - 1));
+  return result;
+}
+
+int main() {
+  {
+    // the retry follows the overflow at once
+    OverflowPhy phy(1);
+    Result result = run(phy, 2);
+    SDI12_CHECK(result.status == SDI12Status::OK);
+    SDI12_CHECK_EQ(result.response, std::string("0\r\n"));
+    SDI12_CHECK_EQ(phy.frames, 2u);
+    // two attempts of ~46 ms, no first byte timeout waited out
+    SDI12_CHECK(result.duration_us < 100000);
+  }
+  {
+    OverflowPhy phy(3);
+    Result result = run(phy, 2);
+    SDI12_CHECK(result.status == SDI12Status::LINE_ERROR);
+    SDI12_CHECK_EQ(phy.frames, 3u);
+  }
+  {
+    OverflowPhy phy(1);
+    Result result = run(phy, 0);
+    SDI12_CHECK(result.status == SDI12Status::LINE_ERROR);
+    SDI12_CHECK_EQ(phy.frames, 1u);
+  }
+  return result("test_overflow");
+}
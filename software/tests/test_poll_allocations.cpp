@@ -0,0 +1,77 @@
+// Whole poll cycles of the generic sensor, from update() to the published values, must
+// not touch the heap once running: aM!/aD0!, aC!/aD0! and aR0!, with and without CRC
+#include <string>
+#include <vector>
+#include "sdi12_alloc_counter.h"
+#include "sdi12_scripted_phy.h"
+#include "sdi12_test.h"
+#include "sdi12/sdi12_sensor.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+static std::string with_crc(const std::string &response) {
+  uint16_t crc = sdi12_crc16(response.data(), response.length());
+  std::string out = response;
+  for (uint8_t i = 0; i < 3; i++)
+    out += sdi12_crc_char(crc, i);
+  return out + "\r\n";
+}
+
+// Allocations of @p cycles poll cycles after the first one, which may set things up
+static size_t poll_allocations(SDI12SensorCommand command, bool crc, int cycles) {
+  const std::vector<ScriptedPhy::Answer> answers = {
+      {"0M!", "00012\r\n"},
+      {"0MC!", "00012\r\n"},
+      {"0C!", "000102\r\n"},
+      {"0CC!", "000102\r\n"},
+      {"0D0!", crc ? with_crc("0+21.5-0.125") : "0+21.5-0.125\r\n"},
+      {"0R0!", "0+21.5-0.125\r\n"},
+      {"0RC0!", with_crc("0+21.5-0.125")},
+  };
+  SDI12HostHal hal;
+  set_sdi12_host_hal(&hal);
+  ScriptedPhy phy(answers);
+  SDI12Bus bus;
+  bus.set_phy(&phy);
+  bus.set_wake_time(0);
+  esphome::sensor::Sensor first("first"), second("second");
+  SDI12SensorComponent sensor;
+  sensor.set_sdi12_address("0");
+  sensor.set_sdi12_bus(&bus);
+  sensor.set_sdi12_crc(crc);
+  sensor.set_command(command, 0);
+  sensor.add_value(0, 1.0f, 0.0f, &first);
+  sensor.add_value(1, 2.0f, 1.0f, &second);
+  bus.setup();
+  esphome::Component *loop = &bus;
+
+  size_t before = 0;
+  for (int cycle = 0; cycle <= cycles; cycle++) {
+    if (cycle == 1)
+      before = allocations();
+    uint32_t published = first.get_publishes();
+    sensor.update();
+    SDI12_CHECK(run_until({loop}, [&] { return first.get_publishes() > published; }, 3000000));
+  }
+  size_t count = allocations() - before;
+  SDI12_CHECK_EQ(first.state, 21.5f);
+  SDI12_CHECK_EQ(second.state, 0.75f);
+  return count;
+}
+
+int main() {
+  const SDI12SensorCommand commands[] = {SDI12SensorCommand::MEASURE, SDI12SensorCommand::CONCURRENT,
+                                         SDI12SensorCommand::CONTINUOUS};
+  const char *names[] = {"aM!", "aC!", "aR0!"};
+  for (int i = 0; i < 3; i++) {
+    for (bool crc : {false, true}) {
+      size_t count = poll_allocations(commands[i], crc, 20);
+      if (count != 0)
+        std::fprintf(stderr, "%s%s: %u allocations in 20 poll cycles\n", names[i], crc ? " with CRC" : "",
+                     static_cast<unsigned>(count));
+      SDI12_CHECK_EQ(count, 0u);
+    }
+  }
+  return result("test_poll_allocations");
+}
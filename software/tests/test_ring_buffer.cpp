@@ -0,0 +1,125 @@
+// SDI12RingBuffer: the single-threaded contract, the wrap-around of its indices, and a
+// producer and a consumer thread hammering it like the ISR and the main loop do
+#include <cstdint>
+#include <thread>
+#include "sdi12_test.h"
+#include "sdi12/sdi12_decoder.h"
+#include "sdi12/sdi12_ring_buffer.h"
+
+using namespace esphome::sdi12;
+
+// Starts its indices anywhere, to cross the wrap-around of the 32-bit counters
+template<typename T, size_t N> class WrappingBuffer : public SDI12RingBuffer<T, N> {
+ public:
+  void start_at(uint32_t index) {
+    this->head_.store(index);
+    this->tail_.store(index);
+  }
+};
+
+static void test_contract() {
+  SDI12RingBuffer<uint8_t, 8> buffer;
+  uint8_t value = 0;
+  SDI12_CHECK(!buffer.pop(value));
+  SDI12_CHECK(!buffer.peek(value));
+  for (uint8_t i = 0; i < 8; i++)
+    SDI12_CHECK(buffer.push(i));
+  SDI12_CHECK_EQ(buffer.size(), 8u);
+  SDI12_CHECK(!buffer.overflowed());
+  // all slots are usable, the next one overflows and is dropped
+  SDI12_CHECK(!buffer.push(99));
+  SDI12_CHECK(buffer.overflowed());
+  SDI12_CHECK(buffer.peek(value));
+  SDI12_CHECK_EQ(value, 0);
+  uint8_t out[5];
+  SDI12_CHECK_EQ(buffer.read(out, sizeof(out)), 5u);
+  SDI12_CHECK_EQ(out[0], 0);
+  SDI12_CHECK_EQ(out[4], 4);
+  // reading doesn't reset the overflow, the owner decides when it was reported
+  SDI12_CHECK(buffer.overflowed());
+  buffer.clear_overflow();
+  SDI12_CHECK(!buffer.overflowed());
+  SDI12_CHECK(buffer.pop(value));
+  SDI12_CHECK_EQ(value, 5);
+  SDI12_CHECK_EQ(buffer.size(), 2u);
+  SDI12_CHECK(buffer.push(42));
+  SDI12_CHECK(buffer.push(43));
+  SDI12_CHECK_EQ(buffer.size(), 4u);
+  buffer.clear();
+  SDI12_CHECK_EQ(buffer.size(), 0u);
+  SDI12_CHECK(!buffer.pop(value));
+}
+
+static void test_wrap_around() {
+  WrappingBuffer<uint16_t, 4> buffer;
+  buffer.start_at(UINT32_MAX - 5);
+  uint16_t next_in = 0, next_out = 0;
+  // the indices run over UINT32_MAX several entries deep
+  for (int round = 0; round < 20; round++) {
+    while (buffer.push(next_in))
+      next_in++;
+    SDI12_CHECK_EQ(buffer.size(), 4u);
+    buffer.clear_overflow();
+    uint16_t value;
+    for (int i = 0; i < 3 && buffer.pop(value); i++)
+      SDI12_CHECK_EQ(value, next_out++);
+  }
+  uint16_t out[4];
+  size_t count = buffer.read(out, 4);
+  for (size_t i = 0; i < count; i++)
+    SDI12_CHECK_EQ(out[i], next_out++);
+  SDI12_CHECK_EQ(next_out, next_in);
+}
+
+// The producer pushes a counting sequence, retrying on a full buffer like an ISR that
+// counts its overflows; the consumer must see every value once and in order
+template<typename T, size_t N, typename Make, typename Value>
+static void test_threads(uint32_t count, Make make, Value value_of) {
+  WrappingBuffer<T, N> buffer;
+  // a little before the wrap-around, so it happens while both threads run
+  buffer.start_at(UINT32_MAX - count / 2);
+  uint32_t full = 0;
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < count; i++) {
+      while (!buffer.push(make(i))) {
+        full++;
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t expected = 0, out_of_order = 0;
+  T batch[N / 2 + 1];
+  while (expected < count) {
+    // alternate single pops and batch reads, as the bus does
+    size_t got = 0;
+    if (expected % 3 == 0) {
+      got = buffer.pop(batch[0]) ? 1 : 0;
+    } else {
+      got = buffer.read(batch, sizeof(batch) / sizeof(batch[0]));
+    }
+    for (size_t i = 0; i < got; i++) {
+      if (value_of(batch[i]) != expected)
+        out_of_order++;
+      expected++;
+    }
+    if (got == 0)
+      std::this_thread::yield();
+  }
+  producer.join();
+  SDI12_CHECK_EQ(out_of_order, 0u);
+  SDI12_CHECK_EQ(buffer.size(), 0u);
+  std::printf("%u values through %u slots, the producer found the buffer full %u times\n", count,
+              static_cast<unsigned>(N), full);
+}
+
+int main() {
+  test_contract();
+  test_wrap_around();
+  test_threads<uint32_t, 64>(2000000, [](uint32_t i) { return i; }, [](uint32_t v) { return v; });
+  // the edges of the deferred decoding, larger than a word so a torn read would show
+  test_threads<SDI12Edge, 16>(
+      1000000, [](uint32_t i) { return SDI12Edge{i, static_cast<uint8_t>(i & 0xFF)}; },
+      [](const SDI12Edge &e) { return (e.time & 0xFF) == e.level ? e.time : UINT32_MAX; });
+  return esphome::sdi12::testing::result("test_ring_buffer");
+}
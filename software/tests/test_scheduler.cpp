@@ -0,0 +1,162 @@
+// The scheduler of the bus: fairness among equals, aging of low priorities, and the
+// queueing latency of polls with and without phase offsets, on emulated sensors
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "sdi12_test.h"
+#include "sdi12/sdi12_emulator.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+// A bus on a loopback line with @p count sensors at addresses 0, 1, ...
+struct Line {
+  explicit Line(size_t count) {
+    set_sdi12_host_hal(&this->hal);
+    this->bus.set_phy(&this->phy);
+    this->bus.set_wake_time(0);
+    this->sensors.resize(count);
+    this->devices.resize(count);
+    for (size_t i = 0; i < count; i++) {
+      this->sensors[i].set_address('0' + i);
+      this->sensors[i].set_phy(&this->phy);
+      this->sensors[i].set_latency(9);
+      this->devices[i].set_sdi12_address(std::string(1, '0' + i));
+      this->devices[i].set_sdi12_bus(&this->bus);
+    }
+    this->bus.setup();
+  }
+  esphome::Component *loop() { return &this->bus; }
+
+  SDI12HostHal hal;
+  SDI12LoopbackPhy phy;
+  SDI12Bus bus;
+  std::vector<SDI12EmulatedSensor> sensors;
+  std::vector<TestDevice> devices;
+};
+
+// Each device asks again as soon as it was answered, the bus is never idle
+struct Saturate {
+  Saturate(Line &line) : line(line), served(line.devices.size()), max_wait(line.devices.size()) {
+    for (size_t i = 0; i < line.devices.size(); i++)
+      this->submit(i);
+  }
+  void submit(size_t i) {
+    this->line.devices[i].send_command_(this->line.devices[i].command_("!"), [this, i](SDI12Status status,
+                                                                                      std::string_view) {
+      if (status == SDI12Status::OK)
+        this->served[i]++;
+      // transactions of the others since this device was last served
+      for (size_t j = 0; j < this->waiting.size(); j++) {
+        if (j != i)
+          this->waiting[j]++;
+      }
+      this->max_wait[i] = std::max(this->max_wait[i], this->waiting[i]);
+      this->waiting[i] = 0;
+      this->submit(i);
+    });
+  }
+
+  Line &line;
+  std::vector<uint32_t> served;
+  std::vector<uint32_t> max_wait;
+  std::vector<uint32_t> waiting = std::vector<uint32_t>(served.size());
+};
+
+static void test_fairness() {
+  Line line(4);
+  Saturate saturate(line);
+  run_for({line.loop()}, 10000000);
+  auto minmax = std::minmax_element(saturate.served.begin(), saturate.served.end());
+  SDI12_CHECK(*minmax.first > 20);
+  // round robin among equals
+  SDI12_CHECK(*minmax.second - *minmax.first <= 1);
+  for (uint32_t wait : saturate.max_wait)
+    SDI12_CHECK(wait <= 3);
+}
+
+static void test_aging() {
+  Line line(3);
+  line.devices[0].set_sdi12_priority(10);
+  line.devices[1].set_sdi12_priority(5);
+  Saturate saturate(line);
+  run_for({line.loop()}, 20000000);
+  // the higher priorities get more of the bus, nobody starves: a device that is passed
+  // over gains a rank per round until it outranks the others
+  SDI12_CHECK(saturate.served[0] > saturate.served[1]);
+  SDI12_CHECK(saturate.served[1] > saturate.served[2]);
+  SDI12_CHECK(saturate.served[2] > 0);
+  SDI12_CHECK(saturate.max_wait[2] <= 12);
+  std::printf("served by priority 10/5/0: %u/%u/%u, longest wait of priority 0: %u transactions\n",
+              saturate.served[0], saturate.served[1], saturate.served[2], saturate.max_wait[2]);
+}
+
+// A scan next to a device that keeps the bus busy still gets its share of it
+static void test_scan_share() {
+  Line line(2);
+  uint32_t served = 0;
+  uint32_t since_probe = 0;
+  uint32_t max_since_probe = 0;
+  uint32_t probes = 0;
+  std::function<void()> poll = [&]() {
+    line.devices[0].send_command_(line.devices[0].command_("!"), [&](SDI12Status, std::string_view) {
+      served++;
+      if (line.bus.get_scan_probes() != probes) {
+        probes = line.bus.get_scan_probes();
+        since_probe = 0;
+      } else if (line.bus.is_scanning()) {
+        max_since_probe = std::max(max_since_probe, ++since_probe);
+      }
+      poll();
+    });
+  };
+  poll();
+  // two configured devices: every other address of the 62 is probed with a!
+  line.bus.start_scan();
+  SDI12_CHECK(run_until({line.loop()}, [&] { return !line.bus.is_scanning(); }, 120000000));
+  SDI12_CHECK_EQ(line.bus.get_scan_probes(), 60u);
+  SDI12_CHECK(max_since_probe <= 7);
+  SDI12_CHECK(served > 7 * 50);
+  std::printf("scan next to a busy device: %u probes in %u ms, %u polls of the device\n",
+              line.bus.get_scan_probes(), line.bus.get_scan_duration_ms(), served);
+}
+
+// @p count devices polling every @p interval_ms, spread by phase offsets or all at once
+static uint32_t worst_latency_ms(size_t count, uint32_t interval_ms, bool spread) {
+  Line line(count);
+  std::vector<uint32_t> due(count);
+  uint32_t worst = 0;
+  std::vector<std::function<void(uint32_t)>> poll(count);
+  for (size_t i = 0; i < count; i++) {
+    poll[i] = [&, i](uint32_t delay_ms) {
+      due[i] = line.hal.now_us() / 1000 + delay_ms;
+      line.devices[i].send_command_(line.devices[i].command_("!"), [&, i](SDI12Status, std::string_view) {
+        uint32_t now = line.hal.now_us() / 1000;
+        worst = std::max(worst, now - due[i]);
+        // the next poll is due an interval after the last, not after the response
+        uint32_t next = due[i] + interval_ms;
+        poll[i](next > now ? next - now : 0);
+      }, delay_ms);
+    };
+    poll[i](spread ? i * interval_ms / count : 0);
+  }
+  run_for({line.loop()}, 30000000);
+  return worst;
+}
+
+int main() {
+  test_fairness();
+  test_aging();
+  test_scan_share();
+
+  // a poll takes ~75 ms of bus time, 8 devices every second use 60 % of it
+  uint32_t bunched = worst_latency_ms(8, 1000, false);
+  uint32_t spread = worst_latency_ms(8, 1000, true);
+  std::printf("worst queueing latency of 8 devices polling every second: %u ms bunched, %u ms spread\n", bunched,
+              spread);
+  SDI12_CHECK(spread < bunched);
+  // spread out, every poll finds the bus free or nearly so
+  SDI12_CHECK(spread < 100);
+  return result("test_scheduler");
+}
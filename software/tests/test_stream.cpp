@@ -0,0 +1,145 @@
+// Streaming of continuous measurements: the aggregates of the sample ring, and a stream
+// on an emulated sensor that leaves room for the other devices on the bus
+#include <cmath>
+#include <vector>
+#include "sdi12_test.h"
+#include "sdi12/sdi12_emulator.h"
+#include "sdi12/sdi12_stream.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+static void test_aggregates() {
+  SDI12SampleRing<8, 2> ring;
+  SDI12Aggregate empty = ring.aggregate(0, 1000, 0);
+  SDI12_CHECK_EQ(empty.count, 0u);
+  SDI12_CHECK(std::isnan(empty.mean) && std::isnan(empty.min) && std::isnan(empty.max));
+
+  // a sample every 100 ms, the second value missing in every third
+  for (uint32_t i = 0; i < 6; i++) {
+    float values[2] = {static_cast<float>(i), i % 3 == 0 ? NAN : 10.0f * i};
+    ring.push(1000 + 100 * i, values);
+  }
+  SDI12_CHECK_EQ(ring.size(), 6u);
+  SDI12Aggregate all = ring.aggregate(0, 10000, 1500);
+  SDI12_CHECK_EQ(all.count, 6u);
+  SDI12_CHECK_EQ(all.mean, 2.5f);
+  SDI12_CHECK_EQ(all.min, 0.0f);
+  SDI12_CHECK_EQ(all.max, 5.0f);
+  // the window ends at now and reaches back window_ms, both ends included
+  SDI12Aggregate last = ring.aggregate(0, 200, 1500);
+  SDI12_CHECK_EQ(last.count, 3u);
+  SDI12_CHECK_EQ(last.mean, 4.0f);
+  SDI12_CHECK_EQ(last.min, 3.0f);
+  // missing values don't count
+  SDI12Aggregate second = ring.aggregate(1, 10000, 1500);
+  SDI12_CHECK_EQ(second.count, 4u);
+  SDI12_CHECK_EQ(second.mean, (10.0f + 20.0f + 40.0f + 50.0f) / 4);
+  // nothing new within the window
+  SDI12_CHECK_EQ(ring.aggregate(0, 100, 1700).count, 0u);
+
+  // the oldest samples are overwritten once the ring is full
+  for (uint32_t i = 6; i < 20; i++) {
+    float values[2] = {static_cast<float>(i), 0};
+    ring.push(1000 + 100 * i, values);
+  }
+  SDI12_CHECK_EQ(ring.size(), 8u);
+  SDI12Aggregate full = ring.aggregate(0, 100000, 2900);
+  SDI12_CHECK_EQ(full.count, 8u);
+  SDI12_CHECK_EQ(full.min, 12.0f);
+  SDI12_CHECK_EQ(full.max, 19.0f);
+
+  // millis() wraps around within the window
+  SDI12SampleRing<4, 1> wrapping;
+  for (uint32_t i = 0; i < 4; i++) {
+    float values[1] = {static_cast<float>(i)};
+    wrapping.push(UINT32_MAX - 150 + 100 * i, values);
+  }
+  SDI12Aggregate wrapped = wrapping.aggregate(0, 250, UINT32_MAX - 150 + 300);
+  SDI12_CHECK_EQ(wrapped.count, 3u);
+  SDI12_CHECK_EQ(wrapped.min, 1.0f);
+
+  ring.clear();
+  SDI12_CHECK_EQ(ring.size(), 0u);
+  SDI12_CHECK_EQ(ring.aggregate(0, 100000, 2900).count, 0u);
+}
+
+static void test_stream() {
+  SDI12HostHal hal;
+  set_sdi12_host_hal(&hal);
+  SDI12LoopbackPhy phy;
+  SDI12EmulatedSensor wind, other;
+  wind.set_address('0');
+  // speed grows by 0.5 per measurement, direction fixed
+  wind.add_value(1.0f, 0.5f, 0.0f, 1);
+  wind.add_value(270.0f, 0.0f, 0.0f, 0);
+  wind.set_phy(&phy);
+  other.set_address('1');
+  other.add_value(21.5f, 0.0f, 0.0f, 1);
+  other.set_measurement_time(0);
+  other.set_phy(&phy);
+
+  SDI12Bus bus;
+  bus.set_phy(&phy);
+  bus.set_wake_time(0);
+  TestDevice stream, poll;
+  stream.set_sdi12_address("0");
+  stream.set_sdi12_bus(&bus);
+  poll.set_sdi12_address("1");
+  poll.set_sdi12_bus(&bus);
+  bus.setup();
+  esphome::Component *loop = &bus;
+
+  SDI12SampleRing<64, 2> samples;
+  uint32_t errors = 0;
+  stream.start_streaming_(0, [&](SDI12Status status, std::string_view response) {
+    float values[2];
+    if (status != SDI12Status::OK || sdi12_parse_values(response.substr(1), values, 2).count != 2) {
+      errors++;
+      return;
+    }
+    samples.push(hal.now_us() / 1000, values);
+  });
+
+  // another device measures every second meanwhile
+  uint32_t measured = 0;
+  std::function<void()> measure = [&] {
+    poll.start_measurement_(MeasurementType::CONCURRENT, [&](SDI12Status status, const float *values, size_t count,
+                                                             const SDI12ValidValues &valid) {
+      if (status == SDI12Status::OK && count == 1 && valid[0] && values[0] == 21.5f)
+        measured++;
+      measure();
+    }, 1000);
+  };
+  measure();
+
+  run_for({loop}, 10000000);
+  SDI12_CHECK_EQ(errors, 0u);
+  // several samples per second, as fast as the bus allows
+  SDI12_CHECK(samples.size() >= 30);
+  SDI12Aggregate speed = samples.aggregate(0, 2000, hal.now_us() / 1000);
+  SDI12Aggregate direction = samples.aggregate(1, 2000, hal.now_us() / 1000);
+  SDI12_CHECK(speed.count >= 6);
+  SDI12_CHECK(speed.max > speed.min);
+  SDI12_CHECK_NEAR(speed.mean, (speed.min + speed.max) / 2, 0.3f);
+  SDI12_CHECK_EQ(direction.min, 270.0f);
+  SDI12_CHECK_EQ(direction.max, 270.0f);
+  // the stream didn't keep the other device off the bus: a measurement is two
+  // transactions, each waits for at most one read of the stream, then a second passes
+  SDI12_CHECK(measured >= 5);
+
+  // stopped, no further reads go out
+  stream.stop_streaming_();
+  uint32_t measured_streaming = measured;
+  run_for({loop}, 1000000);
+  uint32_t answered = wind.get_answered();
+  run_for({loop}, 3000000);
+  SDI12_CHECK_EQ(wind.get_answered(), answered);
+  SDI12_CHECK(measured >= measured_streaming + 2);
+}
+
+int main() {
+  test_aggregates();
+  test_stream();
+  return result("test_stream");
+}
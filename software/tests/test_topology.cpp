@@ -0,0 +1,122 @@
+// The topology cache across reboots, on the in-memory flash of the stubs: the second boot
+// verifies the cached devices instead of scanning, and a bus with nothing but configured
+// devices isn't probed at all once its empty scan is cached
+#include <memory>
+#include <string>
+#include <vector>
+#include "sdi12_test.h"
+#include "sdi12/sdi12_emulator.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+// A boot of a node with a bus on a loopback line: emulated sensors at @p present, of which
+// @p configured have a device in the configuration, scanning at boot if @p scan
+struct Boot {
+  Boot(const std::string &present, const std::string &configured, bool scan = true) {
+    set_sdi12_host_hal(&this->hal);
+    this->bus.set_phy(&this->phy);
+    this->bus.set_wake_time(0);
+    this->bus.set_scan(scan);
+    this->bus.set_topology_cache("bus");
+    this->sensors.resize(present.size());
+    for (size_t i = 0; i < present.size(); i++) {
+      this->sensors[i].set_address(present[i]);
+      this->sensors[i].set_identification("TESTVEND SENSOR1001");
+      this->sensors[i].set_phy(&this->phy);
+    }
+    this->devices.resize(configured.size());
+    for (size_t i = 0; i < configured.size(); i++) {
+      this->devices[i].set_sdi12_address(std::string(1, configured[i]));
+      this->devices[i].set_sdi12_bus(&this->bus);
+    }
+    this->bus.setup();
+    esphome::Component *loop = &this->bus;
+    SDI12_CHECK(run_until({loop}, [this] { return !this->bus.is_scanning(); }, 60000000));
+  }
+
+  SDI12HostHal hal;
+  SDI12LoopbackPhy phy;
+  SDI12Bus bus;
+  std::vector<SDI12EmulatedSensor> sensors;
+  std::vector<TestDevice> devices;
+};
+
+static void test_unconfigured_device() {
+  esphome::global_preferences->reset();
+  uint32_t full_scan;
+  {
+    Boot boot("015", "01");
+    full_scan = boot.bus.get_scan_probes();
+    SDI12_CHECK(full_scan > 50);
+    SDI12_CHECK_EQ(esphome::global_preferences->saves(), 1u);
+  }
+  {
+    // a! to the cached device only, nothing new to save
+    Boot boot("015", "01");
+    SDI12_CHECK_EQ(boot.bus.get_scan_probes(), 1u);
+    SDI12_CHECK_EQ(esphome::global_preferences->saves(), 1u);
+  }
+  {
+    // the cached device is gone: a full scan, and its result replaces the cache
+    Boot boot("01", "01");
+    SDI12_CHECK(boot.bus.get_scan_probes() > full_scan - 5);
+    SDI12_CHECK_EQ(esphome::global_preferences->saves(), 2u);
+  }
+}
+
+static void test_fully_configured_bus() {
+  esphome::global_preferences->reset();
+  {
+    Boot boot("01", "01");
+    SDI12_CHECK(boot.bus.get_scan_probes() > 50);
+    // the empty result is saved, it is a result
+    SDI12_CHECK_EQ(esphome::global_preferences->saves(), 1u);
+  }
+  {
+    Boot boot("01", "01");
+    SDI12_CHECK_EQ(boot.bus.get_scan_probes(), 0u);
+    SDI12_CHECK_EQ(esphome::global_preferences->saves(), 1u);
+  }
+}
+
+static void test_single_configured_device() {
+  // the ?! of a bus with one configured device finds nobody else, cached all the same
+  esphome::global_preferences->reset();
+  {
+    Boot boot("0", "0");
+    SDI12_CHECK_EQ(boot.bus.get_scan_probes(), 1u);
+    SDI12_CHECK_EQ(esphome::global_preferences->saves(), 1u);
+  }
+  {
+    Boot boot("0", "0");
+    SDI12_CHECK_EQ(boot.bus.get_scan_probes(), 0u);
+    SDI12_CHECK_EQ(esphome::global_preferences->saves(), 1u);
+  }
+}
+
+static void test_scan_at_runtime() {
+  // a bus that doesn't scan at boot caches the result of a scan started later on
+  esphome::global_preferences->reset();
+  {
+    Boot boot("015", "01", false);
+    SDI12_CHECK_EQ(boot.bus.get_scan_probes(), 0u);
+    boot.bus.start_scan();
+    esphome::Component *loop = &boot.bus;
+    SDI12_CHECK(run_until({loop}, [&boot] { return !boot.bus.is_scanning(); }, 60000000));
+    SDI12_CHECK(boot.bus.get_scan_probes() > 50);
+    SDI12_CHECK_EQ(esphome::global_preferences->saves(), 1u);
+  }
+  {
+    Boot boot("015", "01");
+    SDI12_CHECK_EQ(boot.bus.get_scan_probes(), 1u);
+  }
+}
+
+int main() {
+  test_unconfigured_device();
+  test_fully_configured_bus();
+  test_single_configured_device();
+  test_scan_at_runtime();
+  return result("test_topology");
+}
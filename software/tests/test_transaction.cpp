@@ -0,0 +1,175 @@
+// Full transactions of the bus, bit-banged on the pins of the virtual board
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "sdi12_test.h"
+#include "sdi12_test_board.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+static const uint8_t RX_PIN = 4;
+static const uint8_t TX_PIN = 5;
+static const uint8_t OE_PIN = 6;
+// the first start bit of a response after the end of the command
+static const uint32_t LATENCY_US = 9000;
+
+int main() {
+  TestBoard board;
+  set_sdi12_host_hal(&board);
+
+  bool service_requests = true;
+  std::string page = "0+21.5-0.125\r\n";
+  board.add_line(RX_PIN, TX_PIN, [&board, &service_requests, &page](const std::string &command) {
+    if (command == "0I!") {
+      board.transmit(RX_PIN, "013VENDOR  MODEL 1.0SN0001\r\n", LATENCY_US);
+    } else if (command == "0M!") {
+      board.transmit(RX_PIN, "00012\r\n", LATENCY_US);
+      // the service request once the values are ready, 0.5 s before the announced second
+      if (service_requests)
+        board.transmit(RX_PIN, "0\r\n", 500000);
+    } else if (command == "0D0!") {
+      board.transmit(RX_PIN, page, LATENCY_US);
+    }
+  });
+
+  TestPin rx(RX_PIN), tx(TX_PIN), oe(OE_PIN);
+  SDI12Bus bus;
+  bus.set_rx_pin(&rx);
+  bus.set_tx_pin(&tx);
+  bus.set_oe_pin(&oe);
+  TestDevice device;
+  device.set_sdi12_address("0");
+  device.set_sdi12_bus(&bus);
+  bus.setup();
+  esphome::Component *loop = &bus;
+
+  // aI!: a plain command and its response
+  bool done = false;
+  SDI12Status status = SDI12Status::NOT_INITIALIZED;
+  std::string response;
+  device.send_command_(device.command_("I!"), [&](SDI12Status s, std::string_view r) {
+    status = s;
+    response = std::string(r);
+    done = true;
+  });
+  SDI12_CHECK(run_until({loop}, [&] { return done; }, 1000000));
+  SDI12_CHECK(status == SDI12Status::OK);
+  SDI12_CHECK_EQ(response, "013VENDOR  MODEL 1.0SN0001\r\n");
+  SDI12_CHECK_EQ(board.commands(RX_PIN).size(), 1u);
+  SDI12_CHECK_EQ(board.breaks(RX_PIN), 1u);
+  SDI12_CHECK_EQ(bus.get_last_line_errors(), SDI12_LINE_OK);
+
+  // aM! and aD0!: the data is read on the service request, before the announced second
+  done = false;
+  std::vector<float> values;
+  SDI12ValidValues valid;
+  uint64_t started = board.now_us();
+  uint64_t finished = 0;
+  device.start_measurement_(MeasurementType::MEASURE, [&](SDI12Status s, const float *v, size_t count,
+                                                           const SDI12ValidValues &ok) {
+    status = s;
+    values.assign(v, v + count);
+    valid = ok;
+    finished = board.now_us();
+    done = true;
+  });
+  SDI12_CHECK(run_until({loop}, [&] { return done; }, 3000000));
+  SDI12_CHECK(status == SDI12Status::OK);
+  SDI12_CHECK_EQ(values.size(), 2u);
+  if (values.size() == 2) {
+    SDI12_CHECK_EQ(values[0], 21.5f);
+    SDI12_CHECK_EQ(values[1], -0.125f);
+  }
+  SDI12_CHECK_EQ(valid.count(), 2u);
+  SDI12_CHECK(finished - started < 1000000);
+  const auto &commands = board.commands(RX_PIN);
+  SDI12_CHECK_EQ(commands.size(), 3u);
+  if (commands.size() == 3) {
+    SDI12_CHECK_EQ(commands[1], "0M!");
+    SDI12_CHECK_EQ(commands[2], "0D0!");
+  }
+
+  auto counters = bus.get_line_counters();
+  SDI12_CHECK_EQ(counters.parity_errors, 0u);
+  SDI12_CHECK_EQ(counters.framing_errors, 0u);
+  SDI12_CHECK_EQ(bus.get_retry_count(), 0u);
+
+  // the command goes out a character per loop(), none blocks for longer than one
+  done = false;
+  device.send_command_(device.command_("I!"), [&](SDI12Status s, std::string_view r) {
+    status = s;
+    done = true;
+  });
+  uint64_t longest = 0;
+  while (!done && board.now_us() - finished < 3000000) {
+    uint64_t before = board.now_us();
+    loop->loop();
+    longest = std::max(longest, board.now_us() - before);
+    board.advance(200);
+  }
+  SDI12_CHECK(status == SDI12Status::OK);
+  SDI12_CHECK(longest < SDI12_CHARACTER_US + 1000);
+
+  // a loop() too slow for the next character in time: the sensors are woken again and
+  // the command is sent in one go
+  run_for({loop}, 200000);
+  done = false;
+  size_t breaks = board.breaks(RX_PIN);
+  device.send_command_(device.command_("I!"), [&](SDI12Status s, std::string_view r) {
+    status = s;
+    response = std::string(r);
+    done = true;
+  });
+  SDI12_CHECK(run_until({loop}, [&] { return done; }, 3000000, 3000));
+  SDI12_CHECK(status == SDI12Status::OK);
+  SDI12_CHECK_EQ(response, "013VENDOR  MODEL 1.0SN0001\r\n");
+  SDI12_CHECK_EQ(board.breaks(RX_PIN), breaks + 2);
+  SDI12_CHECK_EQ(bus.get_retry_count(), 0u);
+
+  // aD0! after the answer to aM!: without a break while the line was active within the
+  // last 87 ms, counting the marking before the command, with a full break after that
+  service_requests = false;
+  auto send = [&](const char *action, uint64_t after_us) {
+    run_for({loop}, after_us);
+    done = false;
+    device.send_command_(device.command_(action), [&](SDI12Status s, std::string_view r) {
+      status = s;
+      done = true;
+    });
+    SDI12_CHECK(run_until({loop}, [&] { return done; }, 1000000));
+    SDI12_CHECK(status == SDI12Status::OK);
+  };
+  send("M!", 200000);
+  breaks = board.breaks(RX_PIN);
+  uint32_t skipped = bus.get_breaks_skipped();
+  send("D0!", 60000);
+  SDI12_CHECK_EQ(board.breaks(RX_PIN), breaks);
+  SDI12_CHECK_EQ(bus.get_breaks_skipped(), skipped + 1);
+  send("D0!", 80000);
+  SDI12_CHECK_EQ(board.breaks(RX_PIN), breaks + 1);
+  SDI12_CHECK_EQ(bus.get_breaks_skipped(), skipped + 1);
+
+  // a value that isn't a number is NAN, and its bit in the mask is clear
+  page = "0+21.5-1x\r\n";
+  run_for({loop}, 200000);
+  done = false;
+  device.start_measurement_(MeasurementType::MEASURE, [&](SDI12Status s, const float *v, size_t count,
+                                                           const SDI12ValidValues &ok) {
+    status = s;
+    values.assign(v, v + count);
+    valid = ok;
+    done = true;
+  });
+  SDI12_CHECK(run_until({loop}, [&] { return done; }, 3000000));
+  SDI12_CHECK(status == SDI12Status::OK);
+  SDI12_CHECK_EQ(values.size(), 2u);
+  SDI12_CHECK(valid[0] && !valid[1]);
+  if (values.size() == 2) {
+    SDI12_CHECK_EQ(values[0], 21.5f);
+    SDI12_CHECK(std::isnan(values[1]));
+  }
+
+  return result("test_transaction");
+}
@@ -0,0 +1,133 @@
+// The value parser: the format of the specification, malformed values, exact results
+// for up to seven digits, and no heap allocation
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "sdi12_alloc_counter.h"
+#include "sdi12_test.h"
+#include "sdi12/sdi12_values.h"
+
+using namespace esphome::sdi12;
+using namespace esphome::sdi12::testing;
+
+static void test_format() {
+  float values[10];
+  auto result = sdi12_parse_values("+1.23-4.5+6\r\n", values, 10);
+  SDI12_CHECK_EQ(result.count, 3u);
+  SDI12_CHECK(result.all_valid(3));
+  SDI12_CHECK_EQ(values[0], 1.23f);
+  SDI12_CHECK_EQ(values[1], -4.5f);
+  SDI12_CHECK_EQ(values[2], 6.0f);
+
+  // a point without digits before or after it, and signed zeros
+  result = sdi12_parse_values("+.5-7.+0-0.000", values, 10);
+  SDI12_CHECK(result.all_valid(4));
+  SDI12_CHECK_EQ(values[0], 0.5f);
+  SDI12_CHECK_EQ(values[1], -7.0f);
+  SDI12_CHECK_EQ(values[2], 0.0f);
+  SDI12_CHECK_EQ(values[3], 0.0f);
+
+  // the largest and smallest of the spec, seven digits
+  result = sdi12_parse_values("+9999999-0.000001", values, 10);
+  SDI12_CHECK(result.all_valid(2));
+  SDI12_CHECK_EQ(values[0], 9999999.0f);
+  SDI12_CHECK_EQ(values[1], -0.000001f);
+
+  // nothing before <CR><LF>, or no values at all
+  SDI12_CHECK_EQ(sdi12_parse_values("\r\n", values, 10).count, 0u);
+  SDI12_CHECK_EQ(sdi12_parse_values("", values, 10).count, 0u);
+  SDI12_CHECK_EQ(sdi12_parse_values("1.5+2", values, 10).count, 0u);
+  // the parser stops at the <CR><LF>
+  SDI12_CHECK_EQ(sdi12_parse_values("+1\r\n+2", values, 10).count, 1u);
+  // and at the capacity of the output
+  result = sdi12_parse_values("+1+2+3+4", values, 2);
+  SDI12_CHECK_EQ(result.count, 2u);
+  SDI12_CHECK_EQ(values[1], 2.0f);
+}
+
+static void test_malformed() {
+  float values[10];
+  // a sign without digits, two points, letters, too many digits: each value is NAN
+  // and flagged, the others are still there
+  auto result = sdi12_parse_values("+1-+2.3.4+5x+1234567890+6\r\n", values, 10);
+  SDI12_CHECK_EQ(result.count, 6u);
+  SDI12_CHECK(!result.all_valid(6));
+  SDI12_CHECK(result.is_valid(0) && values[0] == 1.0f);
+  SDI12_CHECK(!result.is_valid(1) && std::isnan(values[1]));
+  SDI12_CHECK(!result.is_valid(2) && std::isnan(values[2]));
+  SDI12_CHECK(!result.is_valid(3) && std::isnan(values[3]));
+  SDI12_CHECK(!result.is_valid(4) && std::isnan(values[4]));
+  SDI12_CHECK(result.is_valid(5) && values[5] == 6.0f);
+  SDI12_CHECK(!result.is_valid(6));
+}
+
+static void test_many_values() {
+  // 37 values of two characters fill the 75 of an aC! page, more than 64 are possible
+  // with 99 values from a long aR! response, the mask only covers the first 64
+  std::string text;
+  for (int i = 0; i < 70; i++)
+    text += i % 2 ? "-1" : "+2";
+  float values[99];
+  auto result = sdi12_parse_values(text, values, 99);
+  SDI12_CHECK_EQ(result.count, 70u);
+  SDI12_CHECK(result.is_valid(63));
+  SDI12_CHECK(!result.is_valid(64));
+  SDI12_CHECK_EQ(values[69], -1.0f);
+}
+
+static void test_exact() {
+  // up to seven digits the result is the float nearest to the decimal value, as strtof
+  uint32_t state = 12345;
+  int mismatches = 0;
+  for (int i = 0; i < 100000; i++) {
+    state = state * 1664525 + 1013904223;
+    int digits = 1 + (state >> 8) % 7;
+    uint32_t mantissa = (state >> 12) % 10000000;
+    for (int d = digits; d < 7; d++)
+      mantissa /= 10;
+    int decimals = (state >> 4) % (digits + 1);
+    char text[24];
+    std::string number = std::to_string(mantissa);
+    if (decimals > 0) {
+      while (static_cast<int>(number.size()) <= decimals)
+        number.insert(0, "0");
+      number.insert(number.size() - decimals, ".");
+    }
+    std::snprintf(text, sizeof(text), "%c%s", state & 1 ? '-' : '+', number.c_str());
+    float value = NAN;
+    auto result = sdi12_parse_values(text, &value, 1);
+    if (!result.all_valid(1) || value != std::strtof(text, nullptr)) {
+      if (mismatches++ < 5)
+        std::fprintf(stderr, "'%s' parsed as %.9g, strtof gives %.9g\n", text, value, std::strtof(text, nullptr));
+    }
+  }
+  SDI12_CHECK_EQ(mismatches, 0);
+}
+
+static void test_no_allocation() {
+  const char *responses[] = {"+1.23-4.5+6\r\n", "+21.5-0.125+1013.25+45.2+0.0+12.5-3.75\r\n", "+1-+2.3.4\r\n"};
+  float values[SDI12_MAX_VALUES];
+  float sum = 0;
+  // the counter sees what the parser would allocate
+  size_t before = allocations();
+  int *volatile probe = new int(1);
+  delete probe;
+  SDI12_CHECK_EQ(allocations() - before, 1u);
+
+  before = allocations();
+  for (int i = 0; i < 10000; i++) {
+    auto result = sdi12_parse_values(responses[i % 3], values, SDI12_MAX_VALUES);
+    sum += result.count;
+  }
+  SDI12_CHECK_EQ(allocations() - before, 0u);
+  SDI12_CHECK(sum > 0);
+}
+
+int main() {
+  test_format();
+  test_malformed();
+  test_many_values();
+  test_exact();
+  test_no_allocation();
+  return result("test_values");
+}